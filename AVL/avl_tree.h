@@ -3,14 +3,87 @@
 #include <functional>
 #include <fstream>
 #include <chrono>
+#include <queue>
+#include <vector>
+#include <memory>
+#include <memory_resource>
+#include "../Common/memory_usage.h"
+#include "../Common/text_export.h"
+#include "word_normalize.h"
 #pragma once
 using namespace std;
 
-template <typename Key, typename Info>
+// Cached pointer to the node holding the largest info of a subtree, present only in augmented trees
+template <typename NodeType, bool Enabled>
+struct subtree_max_field
+{
+};
+
+template <typename NodeType>
+struct subtree_max_field<NodeType, true>
+{
+    NodeType *subtreeMax = nullptr;
+};
+
+// Balancing policies, a node is rotated once its subtree heights differ by more than max_imbalance
+
+// Classic AVL, the lowest trees for read-heavy use
+struct avl_balance
+{
+    static constexpr int max_imbalance = 1;
+};
+
+// Relaxed AVL, trees get up to a few levels higher but inserts and removes rotate less often
+template <int MaxImbalance = 2>
+struct relaxed_avl_balance
+{
+    static_assert(MaxImbalance >= 1, "imbalance below 1 can not be maintained");
+    static constexpr int max_imbalance = MaxImbalance;
+};
+
+// Stats hooks, called by the tree on every key comparison, rotation and node (de)allocation
+
+// Records nothing, all calls are inlined away
+struct no_tree_stats
+{
+    void on_compare() {}
+    void on_rotation() {}
+    void on_allocate() {}
+    void on_deallocate() {}
+};
+
+struct counting_tree_stats
+{
+    unsigned long long comparisons = 0;
+    unsigned long long rotations = 0;
+    unsigned long long allocations = 0;
+    unsigned long long deallocations = 0;
+
+    void on_compare() { comparisons++; }
+    void on_rotation() { rotations++; }
+    void on_allocate() { allocations++; }
+    void on_deallocate() { deallocations++; }
+};
+
+/**
+ * @brief AVL tree mapping unique keys to infos
+ *
+ * @tparam MaxInfoAugmented if true every node caches the node with the largest (info, key) pair of its subtree,
+ * which lets getLargestInfo answer top-k by info without visiting the whole tree. Info has to support operator<
+ * @tparam Compare strict weak ordering of keys, keys are equal if neither is less than the other
+ * @tparam Allocator allocator rebound to tree nodes, std::pmr::polymorphic_allocator is supported
+ * @tparam Stats hook notified about comparisons, rotations and allocations, see no_tree_stats
+ * @tparam Balance balancing policy, avl_balance or relaxed_avl_balance
+ */
+template <typename Key, typename Info, bool MaxInfoAugmented = false,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<Key>,
+          typename Stats = no_tree_stats,
+          typename Balance = avl_balance>
 class avl_tree
 {
 private:
-    class Node
+    class Node : public subtree_max_field<Node, MaxInfoAugmented>
     {
     private:
         Node *left;
@@ -27,10 +100,40 @@ private:
         friend class avl_tree;
     };
 
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using NodeAllocatorTraits = std::allocator_traits<NodeAllocator>;
+
     Node *root = nullptr;
 
     int size = 0;
 
+    Compare compare;
+
+    NodeAllocator allocator;
+
+    mutable Stats stats;
+
+    bool keyLess(const Key &a, const Key &b) const
+    {
+        stats.on_compare();
+        return compare(a, b);
+    }
+
+    Node *createNode(const Key &key, const Info &info)
+    {
+        Node *node = NodeAllocatorTraits::allocate(allocator, 1);
+        NodeAllocatorTraits::construct(allocator, node, key, info);
+        stats.on_allocate();
+        return node;
+    }
+
+    void destroyNode(Node *node)
+    {
+        NodeAllocatorTraits::destroy(allocator, node);
+        NodeAllocatorTraits::deallocate(allocator, node, 1);
+        stats.on_deallocate();
+    }
+
     template <typename Fn>
     void for_each(Node *node, Fn fn)
     {
@@ -41,6 +144,15 @@ private:
         for_each(node->right, fn);
     }
 
+    void exportHelper(const Node *node, text_exporter &out) const
+    {
+        if (node == nullptr)
+            return;
+        exportHelper(node->left, out);
+        out.element(node->key, node->info);
+        exportHelper(node->right, out);
+    }
+
     void getLargestHelper(Node *node, int &n, vector<pair<Key, Info>> &result)
     {
         if (node == nullptr || n == 0)
@@ -89,7 +201,7 @@ private:
         }
     }
 
-    bool isBalancedHelper(typename avl_tree<Key, Info>::Node *node)
+    bool isBalancedHelper(Node *node)
     {
         if (node == nullptr)
         {
@@ -97,10 +209,10 @@ private:
         }
 
         // Calculate the balance factor of the current node
-        int b_factor = avl_tree<Key, Info>::balanceFactor(node);
+        int b_factor = balanceFactor(node);
 
-        // Check if the balance factor is within the range [-1, 0, 1]
-        if (b_factor < -1 || b_factor > 1)
+        // Check if the balance factor is within the range allowed by balancing policy
+        if (b_factor < -Balance::max_imbalance || b_factor > Balance::max_imbalance)
         {
             return false; // The tree is not balanced at this node
         }
@@ -115,7 +227,7 @@ private:
         {
             clearHelper(node->left);
             clearHelper(node->right);
-            delete node;
+            destroyNode(node);
             size--;
         }
     }
@@ -145,6 +257,187 @@ private:
         }
     }
 
+    // Orders nodes by (info, key), the same ranking maxinfo_selector uses
+    bool infoLess(const Node *a, const Node *b) const
+    {
+        if (a->info < b->info)
+        {
+            return true;
+        }
+        if (b->info < a->info)
+        {
+            return false;
+        }
+        return keyLess(a->key, b->key);
+    }
+
+    // Candidate of best-first search is either a single node (subtree == nullptr) or a whole subtree,
+    // in both cases ranked by the best node it can still yield
+    struct Candidate
+    {
+        const Node *best;
+        const Node *subtree;
+    };
+
+    struct CandidateLess
+    {
+        const avl_tree *tree;
+
+        bool operator()(const Candidate &a, const Candidate &b) const
+        {
+            return tree->infoLess(a.best, b.best);
+        }
+    };
+
+    using CandidateQueue = priority_queue<Candidate, vector<Candidate>, CandidateLess>;
+
+    vector<pair<Key, Info>> largestInfoFrom(CandidateQueue &candidates, int n) const
+    {
+        vector<pair<Key, Info>> result;
+        while (n > 0 && !candidates.empty())
+        {
+            Candidate top = candidates.top();
+            candidates.pop();
+
+            const Node *node = top.subtree;
+            if (node == nullptr || top.best == node)
+            {
+                // Nothing left in the heap can beat it
+                result.push_back(pair<Key, Info>(top.best->key, top.best->info));
+                n--;
+            }
+            else
+            {
+                candidates.push({node, nullptr});
+            }
+
+            if (node != nullptr)
+            {
+                if (node->left != nullptr)
+                {
+                    candidates.push({node->left->subtreeMax, node->left});
+                }
+                if (node->right != nullptr)
+                {
+                    candidates.push({node->right->subtreeMax, node->right});
+                }
+            }
+        }
+        return result;
+    }
+
+    // -1 if key goes before all keys starting with prefix, 0 if it starts with prefix, 1 if it goes after them
+    int prefixOrder(const Key &key, const Key &prefix) const
+    {
+        if (key.compare(0, prefix.size(), prefix) == 0)
+        {
+            return 0;
+        }
+        return keyLess(key, prefix) ? -1 : 1;
+    }
+
+    // Calls fn(node) in key order for nodes whose keys start with prefix
+    template <typename Fn>
+    void prefixNodesHelper(const Node *node, const Key &prefix, Fn &fn) const
+    {
+        if (node == nullptr)
+        {
+            return;
+        }
+
+        int order = prefixOrder(node->key, prefix);
+        if (order >= 0)
+        {
+            prefixNodesHelper(node->left, prefix, fn);
+        }
+        if (order == 0)
+        {
+            fn(node);
+        }
+        if (order <= 0)
+        {
+            prefixNodesHelper(node->right, prefix, fn);
+        }
+    }
+
+    // Pushes O(log size) nodes and subtrees that together hold exactly the keys starting with prefix
+    void collectPrefixCover(const Key &prefix, CandidateQueue &candidates) const
+    {
+        // Descend to the first node inside the range, the range splits there
+        const Node *split = root;
+        int order;
+        while (split != nullptr && (order = prefixOrder(split->key, prefix)) != 0)
+        {
+            split = order < 0 ? split->right : split->left;
+        }
+        if (split == nullptr)
+        {
+            return;
+        }
+        candidates.push({split, nullptr});
+
+        // Left of the split everything is below the upper bound, only the lower bound matters
+        for (const Node *node = split->left; node != nullptr;)
+        {
+            if (prefixOrder(node->key, prefix) < 0)
+            {
+                node = node->right;
+                continue;
+            }
+            candidates.push({node, nullptr});
+            if (node->right != nullptr)
+            {
+                candidates.push({node->right->subtreeMax, node->right});
+            }
+            node = node->left;
+        }
+
+        // Right of the split everything is above the lower bound, only the upper bound matters
+        for (const Node *node = split->right; node != nullptr;)
+        {
+            if (prefixOrder(node->key, prefix) > 0)
+            {
+                node = node->left;
+                continue;
+            }
+            candidates.push({node, nullptr});
+            if (node->left != nullptr)
+            {
+                candidates.push({node->left->subtreeMax, node->left});
+            }
+            node = node->right;
+        }
+    }
+
+    void updateSubtreeMax(Node *node)
+    {
+        if constexpr (MaxInfoAugmented)
+        {
+            if (node == nullptr)
+            {
+                return;
+            }
+
+            Node *best = node;
+            if (node->left != nullptr && infoLess(best, node->left->subtreeMax))
+            {
+                best = node->left->subtreeMax;
+            }
+            if (node->right != nullptr && infoLess(best, node->right->subtreeMax))
+            {
+                best = node->right->subtreeMax;
+            }
+            node->subtreeMax = best;
+        }
+    }
+
+    // Recomputes everything the node caches about its subtree, children have to be up to date
+    void updateNode(Node *node)
+    {
+        updateHeight(node);
+        updateSubtreeMax(node);
+    }
+
     Node *copyHelper(const Node *srcNode)
     {
         if (srcNode == nullptr)
@@ -153,10 +446,11 @@ private:
         }
 
         // Copy the current node
-        Node *newNode = new Node(srcNode->key, srcNode->info);
+        Node *newNode = createNode(srcNode->key, srcNode->info);
         newNode->left = copyHelper(srcNode->left);
         newNode->right = copyHelper(srcNode->right);
         newNode->height = srcNode->height;
+        updateSubtreeMax(newNode);
 
         return newNode;
     }
@@ -167,24 +461,26 @@ private:
         if (node == nullptr)
         {
             size++;
-            return new Node(key, info);
+            Node *newNode = createNode(key, info);
+            updateSubtreeMax(newNode);
+            return newNode;
         }
 
-        // If the key already exists
-        if (key == node->key)
-        {
-            node->info = onKeyExists(node->info, info);
-        }
-        else if (key < node->key)
+        if (keyLess(key, node->key))
         {
             // If the key is less than the current node's key, insert in the left subtree
             node->left = insertHelper(node->left, key, info, onKeyExists);
         }
-        else
+        else if (keyLess(node->key, key))
         {
             // If the key is greater than the current node's key, insert in the right subtree
             node->right = insertHelper(node->right, key, info, onKeyExists);
         }
+        else
+        {
+            // If the key already exists
+            node->info = onKeyExists(node->info, info);
+        }
 
         return balance(node);
     }
@@ -194,10 +490,11 @@ private:
         Node *x = y->left;
         y->left = x->right;
         x->right = y;
+        stats.on_rotation();
 
         // Update heights
-        updateHeight(y);
-        updateHeight(x);
+        updateNode(y);
+        updateNode(x);
 
         return x;
     }
@@ -208,21 +505,22 @@ private:
         Node *y = x->right;
         x->right = y->left;
         y->left = x;
+        stats.on_rotation();
 
         // Update heights
-        updateHeight(x);
-        updateHeight(y);
+        updateNode(x);
+        updateNode(y);
 
         return y;
     }
 
     Node *balance(Node *node)
     {
-        updateHeight(node);
+        updateNode(node);
 
         int b_factor = balanceFactor(node);
 
-        if (b_factor > 1)
+        if (b_factor > Balance::max_imbalance)
         {
             // Left-Right case (LR)
             if (balanceFactor(node->left) < 0)
@@ -233,7 +531,7 @@ private:
             return rotateRight(node);
         }
 
-        if (b_factor < -1)
+        if (b_factor < -Balance::max_imbalance)
         {
             // Right-Left case (RL)
             if (balanceFactor(node->right) > 0)
@@ -258,20 +556,20 @@ private:
 
     Node *findNode(Node *node, const Key &key) const
     {
-
-        if (node == nullptr || key == node->key)
+        if (node == nullptr)
         {
             return node;
         }
 
-        if (key < node->key)
+        if (keyLess(key, node->key))
         {
             return findNode(node->left, key);
         }
-        else
+        else if (keyLess(node->key, key))
         {
             return findNode(node->right, key);
         }
+        return node;
     }
 
     bool removeHelper(Node *&node, const Key &key)
@@ -281,11 +579,11 @@ private:
             return false; // node not found
         }
         bool deleted = false;
-        if (node->key > key)
+        if (keyLess(key, node->key))
         {
             deleted = removeHelper(node->left, key);
         }
-        else if (node->key < key)
+        else if (keyLess(node->key, key))
         {
             deleted = removeHelper(node->right, key);
         }
@@ -305,7 +603,7 @@ private:
                     *node = *temp; // Copy the content of the non-empty child
                 }
 
-                delete temp;
+                destroyNode(temp);
             }
             else
             {
@@ -322,6 +620,15 @@ private:
         return deleted;
     }
 
+    size_t payloadBytes(const Node *node) const
+    {
+        if (node == nullptr)
+        {
+            return 0;
+        }
+        return heap_bytes(node->key) + heap_bytes(node->info) + payloadBytes(node->left) + payloadBytes(node->right);
+    }
+
     void printTree(ostream &os, Node *node, int indent) const
     {
         if (node != nullptr)
@@ -342,10 +649,19 @@ public:
     // Constructor
     avl_tree(){};
 
+    explicit avl_tree(const Compare &compare, const Allocator &allocator = Allocator())
+        : compare(compare), allocator(allocator) {}
+
+    explicit avl_tree(const Allocator &allocator)
+        : allocator(allocator) {}
+
     // Copy constructor
     avl_tree(const avl_tree &src)
+        : compare(src.compare),
+          allocator(NodeAllocatorTraits::select_on_container_copy_construction(src.allocator))
     {
-        *this = src;
+        root = copyHelper(src.root);
+        size = src.size;
     }
 
     // Destructor
@@ -360,6 +676,11 @@ public:
         if (this != &src)
         {
             clear();
+            compare = src.compare;
+            if constexpr (NodeAllocatorTraits::propagate_on_container_copy_assignment::value)
+            {
+                allocator = src.allocator;
+            }
             root = copyHelper(src.root);
             this->size = src.size;
         }
@@ -367,6 +688,7 @@ public:
         return *this;
     }
 
+    // In augmented trees fn must not modify info, cached subtree maxima would go stale
     template <typename Fn>
     void for_each(Fn fn) { for_each(root, fn); }
     vector<pair<Key, Info>> getLargest(int n)
@@ -383,6 +705,97 @@ public:
         return result;
     }
 
+    /**
+     * @brief returns n elements with the largest infos in descending (info, key) order, as maxinfo_selector does.
+     * Available only for MaxInfoAugmented trees, runs best-first over cached subtree maxima in about O(n log size)
+     *
+     * @param n is number of elements to return
+     * @return vector<pair<Key, Info>> elements with the largest infos
+     */
+    vector<pair<Key, Info>> getLargestInfo(int n) const
+    {
+        static_assert(MaxInfoAugmented, "getLargestInfo requires avl_tree with MaxInfoAugmented = true");
+
+        CandidateQueue candidates(CandidateLess{this});
+        if (root != nullptr && n > 0)
+        {
+            candidates.push({root->subtreeMax, root});
+        }
+        return largestInfoFrom(candidates, n);
+    }
+
+    /**
+     * @brief calls fn(key, info) in key order for every key starting with prefix.
+     * Descends to the prefix bound in O(log size) and visits only matching nodes afterwards.
+     * Requires lexicographic ordering of keys, i.e. string keys with default comparator
+     *
+     * @param prefix is the prefix matching keys start with
+     * @param fn is function called for matching elements
+     */
+    template <typename Fn>
+    void prefix_range(const Key &prefix, Fn fn) const
+    {
+        static_assert(is_same_v<Compare, std::less<Key>> || is_same_v<Compare, std::less<>>,
+                      "prefix_range requires lexicographic order of keys");
+        auto visit = [&fn](const Node *node)
+        { fn(node->key, node->info); };
+        prefixNodesHelper(root, prefix, visit);
+    }
+
+    /**
+     * @brief returns n elements with the largest infos among keys starting with prefix,
+     * in descending (info, key) order. Augmented trees run best-first over O(log size) subtrees covering the prefix,
+     * other trees scan the prefix range keeping n best elements
+     *
+     * @param prefix is the prefix matching keys start with
+     * @param n is number of elements to return
+     * @return vector<pair<Key, Info>> matching elements with the largest infos
+     */
+    vector<pair<Key, Info>> prefix_largest_info(const Key &prefix, int n) const
+    {
+        static_assert(is_same_v<Compare, std::less<Key>> || is_same_v<Compare, std::less<>>,
+                      "prefix_largest_info requires lexicographic order of keys");
+        if (n <= 0)
+        {
+            return {};
+        }
+
+        if constexpr (MaxInfoAugmented)
+        {
+            CandidateQueue candidates(CandidateLess{this});
+            collectPrefixCover(prefix, candidates);
+            return largestInfoFrom(candidates, n);
+        }
+        else
+        {
+            // Keeps n best nodes seen so far, the worst of them on top
+            auto greater = [this](const Node *a, const Node *b)
+            { return infoLess(b, a); };
+            priority_queue<const Node *, vector<const Node *>, decltype(greater)> best(greater);
+            auto offer = [&best, &greater, n](const Node *node)
+            {
+                if ((int)best.size() < n)
+                {
+                    best.push(node);
+                }
+                else if (greater(node, best.top()))
+                {
+                    best.pop();
+                    best.push(node);
+                }
+            };
+            prefixNodesHelper(root, prefix, offer);
+
+            vector<pair<Key, Info>> result(best.size());
+            for (auto it = result.rbegin(); it != result.rend(); ++it)
+            {
+                *it = pair<Key, Info>(best.top()->key, best.top()->info);
+                best.pop();
+            }
+            return result;
+        }
+    }
+
     bool empty() const
     {
         return size == 0;
@@ -393,6 +806,43 @@ public:
         return size;
     }
 
+    /**
+     * @brief memory used by the tree. Allocator overhead is estimated for the default allocator only,
+     * other allocators (e.g. memory resources) report it as 0
+     *
+     * @return memory_stats sizes of nodes, estimated allocator overhead and heap memory owned by keys and infos
+     */
+    memory_stats memory_usage() const
+    {
+        memory_stats result;
+        result.elements = size;
+        result.node_bytes = sizeof(*this) + size * sizeof(Node);
+        if constexpr (is_same_v<NodeAllocator, std::allocator<Node>>)
+        {
+            result.allocator_overhead = size * allocation_overhead(sizeof(Node));
+        }
+        result.payload_bytes = payloadBytes(root);
+        return result;
+    }
+
+    /**
+     * @brief writes all elements to out in key order, as a list "[(key, info), ...]".
+     * Unlike operator<< it has no size limit
+     *
+     * @param out exporter, its buffer can be shared by several exports
+     */
+    void export_text(text_exporter &out) const
+    {
+        out.open();
+        exportHelper(root, out);
+        out.close();
+    }
+
+    const Stats &getStats() const
+    {
+        return stats;
+    }
+
     /**
      * @brief removes all elements from avl tree
      *
@@ -456,6 +906,7 @@ public:
      */
     Info &operator[](const Key &key)
     {
+        static_assert(!MaxInfoAugmented, "info of augmented tree can be changed only through insert");
         Node *node = findNode(root, key);
         if (node == nullptr)
         {
@@ -501,9 +952,14 @@ public:
 
 // External methods
 
-template <typename Key, typename Info>
-std::vector<std::pair<Key, Info>> maxinfo_selector(const avl_tree<Key, Info> &tree, unsigned cnt)
+template <typename Key, typename Info, bool MaxInfoAugmented, typename... Policies>
+std::vector<std::pair<Key, Info>> maxinfo_selector(const avl_tree<Key, Info, MaxInfoAugmented, Policies...> &tree, unsigned cnt)
 {
+    if constexpr (MaxInfoAugmented)
+    {
+        return tree.getLargestInfo(cnt);
+    }
+
     avl_tree<pair<Info, Key>, int> inverted;
 
     auto copy = tree;
@@ -526,14 +982,37 @@ std::vector<std::pair<Key, Info>> maxinfo_selector(const avl_tree<Key, Info> &tr
     return aboba;
 }
 
-avl_tree<string, int> count_words(istream &is)
+/**
+ * @brief adds counts of words read from the stream to an existing tree, so it can be kept live
+ *
+ * @param is stream words are read from
+ * @param wc tree the counts are added to
+ * @param mode is combination of word_normalization steps applied to words before counting
+ */
+template <bool MaxInfoAugmented, typename... Policies>
+void count_words(istream &is, avl_tree<string, int, MaxInfoAugmented, Policies...> &wc,
+                 word_normalization mode = normalize_none)
 {
-    std::string word;
-    avl_tree<string, int> wc;
-    while (is >> word)
+    auto add = [](const int &oldValue, const int &newValue)
+    { return oldValue + newValue; };
+
+    if (mode == normalize_none)
     {
-        wc.insert(word, 1, [](const int &oldValue, const int &newValue)
-                  { return oldValue + newValue; });
+        std::string word;
+        while (is >> word)
+        {
+            wc.insert(word, 1, add);
+        }
+        return;
     }
+
+    read_normalized_words(is, mode, [&wc, &add](const std::string &word)
+                          { wc.insert(word, 1, add); });
+}
+
+avl_tree<string, int> count_words(istream &is, word_normalization mode = normalize_none)
+{
+    avl_tree<string, int> wc;
+    count_words(is, wc, mode);
     return wc;
 }
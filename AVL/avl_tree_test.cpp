@@ -1,6 +1,7 @@
 #include "avl_tree.h"
 #include <iostream>
 #include <cassert>
+#include <cstdlib>
 #include "avl_tree_test.h"
 
 using namespace std;
@@ -362,6 +363,290 @@ void test_maxinfo_selector()
     std::cout << "All maxinfo_selector tests passed!" << std::endl;
 }
 
+void test_largest_info()
+{
+    avl_tree<int, int, true> augmented;
+    avl_tree<int, int> plain;
+
+    srand(42);
+    for (int i = 0; i < 2000; i++)
+    {
+        int key = rand() % 500;
+        int info = rand() % 50;
+        augmented.insert(key, info);
+        plain.insert(key, info);
+        if (i % 3 == 0)
+        {
+            int removed = rand() % 500;
+            assert(augmented.remove(removed) == plain.remove(removed));
+        }
+        if (i % 100 == 0)
+        {
+            assert(augmented.getLargestInfo(10) == maxinfo_selector(plain, 10));
+        }
+    }
+    assert(augmented.isBalanced());
+    assert(augmented.getLargestInfo(plain.getSize() + 5) == maxinfo_selector(plain, plain.getSize() + 5));
+    assert(augmented.getLargestInfo(0).empty());
+
+    // Existing keys updated through onKeyExists keep the cache valid
+    augmented.insert(7, 1000, [](const int &oldInfo, const int &newInfo)
+                     { return oldInfo + newInfo; });
+    assert(augmented.getLargestInfo(1)[0].first == 7);
+
+    // Copies carry valid cached maxima
+    auto copy = augmented;
+    assert(copy.getLargestInfo(20) == augmented.getLargestInfo(20));
+
+    ifstream voyage("beagle_voyage.txt");
+    avl_tree<string, int, true> live;
+    count_words(voyage, live);
+    ifstream voyage_again("beagle_voyage.txt");
+    auto wc = count_words(voyage_again);
+    assert(maxinfo_selector(live, 20) == maxinfo_selector(wc, 20));
+
+    cout << "All largest info tests passed!" << endl;
+}
+
+void test_policies()
+{
+    // Comparator reverses the order
+    avl_tree<int, std::string, false, std::greater<int>> reversed;
+    reversed.insert(10, "A");
+    reversed.insert(5, "B");
+    reversed.insert(15, "C");
+    std::vector<std::pair<int, std::string>> expectedElements = {{15, "C"}, {10, "A"}, {5, "B"}};
+    assert(reversed.getSmallest(3) == expectedElements);
+    assert(reversed.find(5) && !reversed.find(6));
+    assert(reversed.remove(10) && reversed.getSize() == 2);
+
+    // Relaxed balancing rotates less than strict AVL on the same input
+    avl_tree<int, int, false, std::less<int>, std::allocator<int>, counting_tree_stats> strict;
+    avl_tree<int, int, false, std::less<int>, std::allocator<int>, counting_tree_stats, relaxed_avl_balance<2>> relaxed;
+    srand(7);
+    for (int i = 0; i < 5000; i++)
+    {
+        int key = rand() % 2000;
+        strict.insert(key, i);
+        relaxed.insert(key, i);
+        if (i % 4 == 0)
+        {
+            int removed = rand() % 2000;
+            assert(strict.remove(removed) == relaxed.remove(removed));
+        }
+    }
+    assert(strict.isBalanced());
+    assert(relaxed.isBalanced());
+    assert(strict.getSize() == relaxed.getSize());
+    assert(strict.getLargest(50) == relaxed.getLargest(50));
+    assert(relaxed.getStats().rotations < strict.getStats().rotations);
+    assert(strict.getStats().allocations - strict.getStats().deallocations == (unsigned)strict.getSize());
+
+    // Nodes allocated from a memory resource
+    std::pmr::monotonic_buffer_resource arena;
+    avl_tree<std::string, int, true, std::less<std::string>, std::pmr::polymorphic_allocator<std::string>> pooled(&arena);
+    ifstream vagner("Vagner_song.txt");
+    count_words(vagner, pooled);
+    assert(pooled.getSize() == 88);
+    auto pooled_copy = pooled;
+    assert(pooled_copy.getLargestInfo(5) == pooled.getLargestInfo(5));
+
+    std::cout << "All policy tests passed!" << std::endl;
+}
+
+void test_prefix_range()
+{
+    ifstream voyage("beagle_voyage.txt");
+    avl_tree<string, int, true> augmented;
+    count_words(voyage, augmented);
+    ifstream voyage_again("beagle_voyage.txt");
+    auto wc = count_words(voyage_again);
+
+    for (const string prefix : {"th", "a", "Beag", "zz", "", "w"})
+    {
+        // Brute force over the whole tree
+        std::vector<std::pair<string, int>> expected;
+        wc.for_each([&expected, &prefix](const string &key, const int &info)
+                    {
+            if (key.compare(0, prefix.size(), prefix) == 0)
+            {
+                expected.push_back(make_pair(key, info));
+            } });
+
+        std::vector<std::pair<string, int>> elements;
+        wc.prefix_range(prefix, [&elements](const string &key, const int &info)
+                        { elements.push_back(make_pair(key, info)); });
+        assert(elements == expected);
+
+        avl_tree<pair<int, string>, int> inverted;
+        for (auto &element : expected)
+        {
+            inverted.insert(make_pair(element.second, element.first), 1);
+        }
+        std::vector<std::pair<string, int>> expected_top;
+        for (auto &element : inverted.getLargest(10))
+        {
+            expected_top.push_back(make_pair(element.first.second, element.first.first));
+        }
+        assert(wc.prefix_largest_info(prefix, 10) == expected_top);
+        assert(augmented.prefix_largest_info(prefix, 10) == expected_top);
+    }
+    assert(wc.prefix_largest_info("th", 0).empty());
+
+    std::cout << "All prefix range tests passed!" << std::endl;
+}
+
+void test_memory_usage()
+{
+    avl_tree<int, std::string> tree;
+    assert(tree.memory_usage().elements == 0);
+    assert(tree.memory_usage().total() == sizeof(tree));
+
+    tree.insert(10, "A");
+    tree.insert(5, std::string(200, 'B'));
+    memory_stats stats = tree.memory_usage();
+    assert(stats.elements == 2);
+    assert(stats.allocator_overhead > 0);
+    assert(stats.payload_bytes == heap_bytes(std::string(200, 'B')));
+
+    std::pmr::monotonic_buffer_resource arena;
+    avl_tree<int, std::string, false, std::less<int>, std::pmr::polymorphic_allocator<int>> pooled(&arena);
+    pooled.insert(10, "A");
+    assert(pooled.memory_usage().allocator_overhead == 0);
+
+    std::cout << "All memory usage tests passed!" << std::endl;
+}
+
+void test_export_text()
+{
+    avl_tree<int, std::string> tree;
+    tree.insert(10, "A");
+    tree.insert(5, "B");
+    tree.insert(15, "C");
+
+    std::ostringstream small;
+    export_text(small, tree);
+    assert(small.str() == "[(5, B), (10, A), (15, C)]");
+
+    // Trees too big for operator<< are exported too, a small buffer is flushed many times
+    avl_tree<int, double> big;
+    std::string expected = "[";
+    for (int i = 0; i < 1000; i++)
+    {
+        big.insert(i, i / 4.0);
+        std::ostringstream element;
+        element << (i == 0 ? "" : ", ") << "(" << i << ", " << i / 4.0 << ")";
+        expected += element.str();
+    }
+    expected += "]";
+    std::ostringstream output;
+    {
+        text_exporter out(output, 128);
+        big.export_text(out);
+    }
+    assert(output.str() == expected);
+
+    avl_tree<int, int> empty;
+    std::ostringstream none;
+    export_text(none, empty);
+    assert(none.str() == "[]");
+
+    std::cout << "All export tests passed!" << std::endl;
+}
+
+void test_word_normalization()
+{
+    char buffer[] = "The QUICK brown Fox jumps over THE lazy Dog, \xD0\x9F\xD1\x80\xD0\xB8 ABCXYZ@[`{";
+    char expected[] = "the quick brown fox jumps over the lazy dog, \xD0\x9F\xD1\x80\xD0\xB8 abcxyz@[`{";
+    ascii_lowercase(buffer, sizeof(buffer) - 1);
+    assert(string(buffer) == string(expected));
+
+    string word = "\"Voyage,\"";
+    normalize_word(word, normalize_all);
+    assert(word == "voyage");
+    word = "don't.";
+    normalize_word(word, normalize_strip_punctuation);
+    assert(word == "don't");
+    word = "--";
+    normalize_word(word, normalize_all);
+    assert(word.empty());
+
+    std::istringstream text("The voyage, the VOYAGE. -- (the) don't");
+    auto wc = count_words(text, normalize_all);
+    assert(wc.getSize() == 3);
+    assert(wc["the"] == 3);
+    assert(wc["voyage"] == 2);
+    assert(wc["don't"] == 1);
+
+    std::istringstream raw("The voyage, the VOYAGE.");
+    assert(count_words(raw, normalize_none).getSize() == 4);
+
+    // "(oun)" and "oun" become one key
+    ifstream bandera("bandera.txt");
+    assert(count_words(bandera, normalize_all).getSize() == 136);
+
+    // Capitalized and punctuated text, "The", "THE" and "the" or "Beagle," and "BEAGLE." collapse into one key
+    word_normalization modes[] = {normalize_none, normalize_lowercase, normalize_strip_punctuation, normalize_all};
+    int sizes[] = {219, 211, 213, 202};
+    for (int i = 0; i < 4; i++)
+    {
+        ifstream preface("beagle_preface.txt");
+        assert(count_words(preface, modes[i]).getSize() == sizes[i]);
+    }
+    ifstream preface("beagle_preface.txt");
+    auto preface_words = count_words(preface, normalize_all);
+    assert(preface_words["beagle"] == 4);
+    assert(preface_words["voyage"] == 5);
+
+    // Vectorized classification agrees with the scalar one on every byte value, in every lane
+    std::string bytes;
+    for (int round = 0; round < 3; round++)
+    {
+        for (int c = 0; c < 256; c++)
+        {
+            bytes += (char)c;
+        }
+    }
+    bytes.resize(bytes.size() - 5);
+    std::vector<uint64_t> separators, punctuation, scalar_separators, scalar_punctuation;
+    classify_bytes(bytes.data(), bytes.size(), separators, punctuation);
+    classify_bytes_scalar(bytes.data(), bytes.size(), scalar_separators, scalar_punctuation);
+    assert(separators == scalar_separators && punctuation == scalar_punctuation);
+
+    // Bit scans give the words of operator>>, also those crossing 64 byte words and blocks of the stream
+    const char *pieces[] = {"word", "\"Quoted,\"", "--", "don't.", "(x)", "A", "\xD0\x9F!", "...end", "  ", "\t\n"};
+    std::string long_text;
+    srand(11);
+    while (long_text.size() < 200000)
+    {
+        long_text += pieces[rand() % 10];
+        long_text += rand() % 4 == 0 ? "\n" : " ";
+        if (rand() % 100 == 0)
+        {
+            long_text += std::string(70 + rand() % 60, rand() % 2 ? 'z' : '!');
+        }
+    }
+    for (word_normalization mode : modes)
+    {
+        std::vector<std::string> expected_words, read_words;
+        std::istringstream reference(long_text);
+        while (reference >> word)
+        {
+            normalize_word(word, mode);
+            if (!word.empty())
+            {
+                expected_words.push_back(word);
+            }
+        }
+        std::istringstream is(long_text);
+        read_normalized_words(is, mode, [&read_words](const std::string &read)
+                              { read_words.push_back(read); });
+        assert(read_words == expected_words);
+    }
+
+    std::cout << "All word normalization tests passed!" << std::endl;
+}
+
 void test_word_count()
 {
 
@@ -402,6 +687,84 @@ void time_measurement()
     }
 }
 
+void prefix_time_measurement()
+{
+    avl_tree<string, int, true> vocabulary;
+    srand(1);
+    for (int i = 0; i < 300000; i++)
+    {
+        string word;
+        for (int len = 3 + rand() % 8; len > 0; len--)
+        {
+            word += (char)('a' + rand() % 26);
+        }
+        vocabulary.insert(word, rand() % 1000);
+    }
+
+    int matched = 0;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    vocabulary.for_each([&matched](const string &key, const int &)
+                        { matched += key.compare(0, 3, "abc") == 0; });
+    auto scan_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int rep = 0; rep < 1000; rep++)
+    {
+        vocabulary.prefix_largest_info("abc", 10);
+    }
+    auto prefix_time = (std::chrono::high_resolution_clock::now() - start_time) / 1000;
+
+    std::cout << "Prefix top-10 over " << vocabulary.getSize() << " words (" << matched << " matching): full scan "
+              << scan_time / std::chrono::microseconds(1) << "us, prefix_largest_info "
+              << prefix_time / std::chrono::microseconds(1) << "us" << endl;
+}
+
+void normalization_time_measurement()
+{
+    std::pair<const char *, word_normalization> modes[] = {
+        {"none", normalize_none},
+        {"lowercase", normalize_lowercase},
+        {"strip punctuation", normalize_strip_punctuation},
+        {"all", normalize_all}};
+    for (auto &mode : modes)
+    {
+        ifstream is("beagle_voyage.txt");
+        auto start_time = std::chrono::high_resolution_clock::now();
+        auto wc = count_words(is, mode.second);
+        auto time = std::chrono::high_resolution_clock::now() - start_time;
+        // The voyage text is already lowercased without punctuation, the preface keeps the original spelling
+        ifstream preface("beagle_preface.txt");
+        std::cout << "Normalization " << mode.first << ": " << time / std::chrono::milliseconds(1) << "ms, "
+                  << wc.getSize() << " words, preface " << count_words(preface, mode.second).getSize() << " words" << endl;
+    }
+
+    std::string text(1 << 24, 'A');
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ascii_lowercase_scalar(text.data(), text.size());
+    auto scalar_time = std::chrono::high_resolution_clock::now() - start_time;
+    std::fill(text.begin(), text.end(), 'A');
+    start_time = std::chrono::high_resolution_clock::now();
+    ascii_lowercase(text.data(), text.size());
+    auto simd_time = std::chrono::high_resolution_clock::now() - start_time;
+    std::cout << "Lowercasing 16MB: scalar " << scalar_time / std::chrono::microseconds(1) << "us, vectorized "
+              << simd_time / std::chrono::microseconds(1) << "us" << endl;
+
+    std::string words;
+    while (words.size() < text.size())
+    {
+        words += "\"Word,\" (the) don't. ";
+    }
+    std::vector<uint64_t> separators, punctuation;
+    start_time = std::chrono::high_resolution_clock::now();
+    classify_bytes_scalar(words.data(), words.size(), separators, punctuation);
+    scalar_time = std::chrono::high_resolution_clock::now() - start_time;
+    start_time = std::chrono::high_resolution_clock::now();
+    classify_bytes(words.data(), words.size(), separators, punctuation);
+    simd_time = std::chrono::high_resolution_clock::now() - start_time;
+    std::cout << "Classifying separators and punctuation of 16MB: scalar " << scalar_time / std::chrono::microseconds(1)
+              << "us, vectorized " << simd_time / std::chrono::microseconds(1) << "us" << endl;
+}
+
 int main()
 {
     test_clear_get_size();
@@ -419,7 +782,15 @@ int main()
 
     // External functions tests
     test_maxinfo_selector();
+    test_largest_info();
+    test_policies();
+    test_prefix_range();
+    test_memory_usage();
+    test_export_text();
+    test_word_normalization();
     test_word_count();
 
     time_measurement();
+    prefix_time_measurement();
+    normalization_time_measurement();
 }
\ No newline at end of file
@@ -10,4 +10,10 @@ void test_print();
 void test_get_largest();
 void test_get_smallest();
 void test_for_each();
+void test_largest_info();
+void test_policies();
+void test_prefix_range();
+void test_memory_usage();
+void test_export_text();
+void test_word_normalization();
 void test_word_count();
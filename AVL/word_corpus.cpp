@@ -0,0 +1,166 @@
+// Counts words of a whole corpus, files are processed concurrently on a pool of threads
+//
+// Build: g++ -std=c++17 -O2 -pthread word_corpus.cpp -o word_corpus
+// Usage: word_corpus [-n top_count] [-j threads] [--normalize] <directory or files...>
+//   --normalize lowercases words and strips punctuation around them before counting
+
+#include "avl_tree.h"
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+struct file_result
+{
+    string path;
+    uintmax_t bytes = 0;
+    long long words = 0;
+    double seconds = 0;
+    avl_tree<string, int> counts;
+};
+
+void usage()
+{
+    cerr << "Usage: word_corpus [-n top_count] [-j threads] [--normalize] <directory or files...>" << endl;
+}
+
+double megabytes_per_second(uintmax_t bytes, double seconds)
+{
+    return seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0;
+}
+
+void count_file(file_result &result, word_normalization mode)
+{
+    auto start_time = std::chrono::steady_clock::now();
+
+    ifstream is(result.path);
+    count_words(is, result.counts, mode);
+    result.bytes = fs::file_size(result.path);
+
+    long long words = 0;
+    result.counts.for_each([&words](const string &, const int &count)
+                           { words += count; });
+    result.words = words;
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+int main(int argc, char **argv)
+{
+    int top_count = 20;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    word_normalization mode = normalize_none;
+    vector<string> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if ((arg == "-n" || arg == "-j") && i + 1 < argc)
+        {
+            int value = atoi(argv[++i]);
+            if (value <= 0)
+            {
+                usage();
+                return 1;
+            }
+            (arg == "-n" ? top_count : threads) = value;
+        }
+        else if (arg == "--normalize")
+        {
+            mode = normalize_all;
+        }
+        else if (fs::is_directory(arg))
+        {
+            for (const auto &entry : fs::recursive_directory_iterator(arg))
+            {
+                if (entry.is_regular_file())
+                {
+                    paths.push_back(entry.path().string());
+                }
+            }
+        }
+        else if (fs::is_regular_file(arg))
+        {
+            paths.push_back(arg);
+        }
+        else
+        {
+            cerr << "Can not read " << arg << endl;
+            usage();
+            return 1;
+        }
+    }
+    if (paths.empty())
+    {
+        usage();
+        return 1;
+    }
+
+    vector<file_result> results(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        results[i].path = paths[i];
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Workers take the next unprocessed file until none are left
+    atomic<size_t> next_file(0);
+    vector<thread> pool;
+    for (size_t t = 0; t < std::min<size_t>(threads, results.size()); t++)
+    {
+        pool.emplace_back([&results, &next_file, mode]()
+                          {
+            for (size_t i = next_file++; i < results.size(); i = next_file++)
+            {
+                count_file(results[i], mode);
+            } });
+    }
+    for (auto &worker : pool)
+    {
+        worker.join();
+    }
+
+    // Per-file trees are merged in input order, so the output does not depend on scheduling
+    avl_tree<string, int, true> total;
+    uintmax_t total_bytes = 0;
+    long long total_words = 0;
+    for (auto &result : results)
+    {
+        result.counts.for_each([&total](const string &word, const int &count)
+                               { total.insert(word, count, [](const int &oldValue, const int &newValue)
+                                              { return oldValue + newValue; }); });
+        total_bytes += result.bytes;
+        total_words += result.words;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    cout << left << setw(40) << "file" << right << setw(12) << "bytes" << setw(12) << "words"
+         << setw(10) << "unique" << setw(10) << "ms" << setw(10) << "MB/s" << "\n";
+    for (const auto &result : results)
+    {
+        cout << left << setw(40) << result.path << right << setw(12) << result.bytes << setw(12) << result.words
+             << setw(10) << result.counts.getSize() << setw(10) << fixed << setprecision(1) << result.seconds * 1000
+             << setw(10) << megabytes_per_second(result.bytes, result.seconds) << "\n";
+    }
+
+    cout << "\nTop " << top_count << " words:\n";
+    for (const auto &pair : total.getLargestInfo(top_count))
+    {
+        cout << setw(10) << pair.second << "  " << pair.first << "\n";
+    }
+
+    cout << "\n"
+         << results.size() << " files, " << total_bytes << " bytes, " << total_words << " words, "
+         << total.getSize() << " unique words\n"
+         << pool.size() << " threads, " << setprecision(1) << seconds * 1000 << " ms, "
+         << megabytes_per_second(total_bytes, seconds) << " MB/s" << endl;
+
+    return 0;
+}
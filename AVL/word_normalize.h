@@ -0,0 +1,298 @@
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#pragma once
+
+/**
+ * @brief steps of word normalization, combined with |
+ *
+ */
+enum word_normalization : unsigned
+{
+    // words are counted exactly as read
+    normalize_none = 0,
+    // ASCII letters are lowercased, other bytes (UTF-8 sequences included) are kept
+    normalize_lowercase = 1,
+    // ASCII punctuation is stripped from both ends of a word, inner punctuation like in "don't" is kept
+    normalize_strip_punctuation = 2,
+    normalize_all = normalize_lowercase | normalize_strip_punctuation
+};
+
+inline word_normalization operator|(word_normalization a, word_normalization b)
+{
+    return word_normalization((unsigned)a | (unsigned)b);
+}
+
+/**
+ * @brief lowercases ASCII letters of buffer in place, one byte at a time.
+ * Bytes of multibyte UTF-8 sequences are all >= 0x80 and are never changed
+ *
+ */
+inline void ascii_lowercase_scalar(char *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        unsigned char c = data[i];
+        if (static_cast<unsigned char>(c - 'A') < 26u)
+        {
+            data[i] = c | 0x20;
+        }
+    }
+}
+
+/**
+ * @brief lowercases ASCII letters of buffer in place, 16 bytes at a time where SSE2 is available
+ *
+ */
+inline void ascii_lowercase(char *data, size_t size)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    // Signed compares, bytes >= 0x80 are negative and never fall into 'A'..'Z'
+    const __m128i before_upper = _mm_set1_epi8('A' - 1);
+    const __m128i after_upper = _mm_set1_epi8('Z' + 1);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, before_upper), _mm_cmplt_epi8(chunk, after_upper));
+        chunk = _mm_or_si128(chunk, _mm_and_si128(upper, case_bit));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i), chunk);
+    }
+#endif
+    ascii_lowercase_scalar(data + i, size - i);
+}
+
+inline bool is_ascii_punctuation(unsigned char c)
+{
+    return (c >= '!' && c <= '/') || (c >= ':' && c <= '@') || (c >= '[' && c <= '`') || (c >= '{' && c <= '~');
+}
+
+/**
+ * @brief normalizes word in place
+ *
+ * @param word is the word to be normalized, may become empty
+ * @param mode is combination of word_normalization steps
+ */
+inline void normalize_word(std::string &word, word_normalization mode)
+{
+    if (mode & normalize_strip_punctuation)
+    {
+        size_t end = word.size();
+        while (end > 0 && is_ascii_punctuation(word[end - 1]))
+        {
+            end--;
+        }
+        size_t begin = 0;
+        while (begin < end && is_ascii_punctuation(word[begin]))
+        {
+            begin++;
+        }
+        if (begin != 0 || end != word.size())
+        {
+            word.erase(end);
+            word.erase(0, begin);
+        }
+    }
+    if (mode & normalize_lowercase)
+    {
+        ascii_lowercase(word.data(), word.size());
+    }
+}
+
+inline bool is_word_separator(unsigned char c)
+{
+    // Same characters operator>> skips in the default locale
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Sets bits of bytes [from, size) in separators and punctuation, one byte at a time
+inline void classify_bytes_from(const char *data, size_t from, size_t size, std::vector<uint64_t> &separators,
+                                std::vector<uint64_t> &punctuation)
+{
+    for (size_t i = from; i < size; i++)
+    {
+        uint64_t bit = uint64_t(1) << (i % 64);
+        if (is_word_separator(data[i]))
+        {
+            separators[i / 64] |= bit;
+        }
+        else if (is_ascii_punctuation(data[i]))
+        {
+            punctuation[i / 64] |= bit;
+        }
+    }
+}
+
+/**
+ * @brief classifies bytes of buffer one byte at a time, bit i of separators (punctuation) is set
+ * when byte i is a word separator (ASCII punctuation)
+ *
+ */
+inline void classify_bytes_scalar(const char *data, size_t size, std::vector<uint64_t> &separators,
+                                  std::vector<uint64_t> &punctuation)
+{
+    separators.assign((size + 63) / 64, 0);
+    punctuation.assign((size + 63) / 64, 0);
+    classify_bytes_from(data, 0, size, separators, punctuation);
+}
+
+/**
+ * @brief classifies bytes of buffer like classify_bytes_scalar(), 16 bytes at a time where SSE2 is available
+ *
+ */
+inline void classify_bytes(const char *data, size_t size, std::vector<uint64_t> &separators,
+                           std::vector<uint64_t> &punctuation)
+{
+    separators.assign((size + 63) / 64, 0);
+    punctuation.assign((size + 63) / 64, 0);
+    size_t i = 0;
+#ifdef __SSE2__
+    // Punctuation is a printable byte that is neither a digit nor a letter, bytes >= 0x80 are negative
+    // and never printable. Letters are compared with the case bit set
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i before_tab = _mm_set1_epi8('\t' - 1);
+    const __m128i after_return = _mm_set1_epi8('\r' + 1);
+    const __m128i before_digit = _mm_set1_epi8('0' - 1);
+    const __m128i after_digit = _mm_set1_epi8('9' + 1);
+    const __m128i before_lower = _mm_set1_epi8('a' - 1);
+    const __m128i after_lower = _mm_set1_epi8('z' + 1);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i separator = _mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                                         _mm_and_si128(_mm_cmpgt_epi8(chunk, before_tab), _mm_cmplt_epi8(chunk, after_return)));
+        __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(chunk, space), _mm_cmplt_epi8(chunk, del));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(chunk, before_digit), _mm_cmplt_epi8(chunk, after_digit));
+        __m128i folded = _mm_or_si128(chunk, case_bit);
+        __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(folded, before_lower), _mm_cmplt_epi8(folded, after_lower));
+        __m128i punct = _mm_andnot_si128(_mm_or_si128(digit, letter), printable);
+        separators[i / 64] |= uint64_t(unsigned(_mm_movemask_epi8(separator))) << (i % 64);
+        punctuation[i / 64] |= uint64_t(unsigned(_mm_movemask_epi8(punct))) << (i % 64);
+    }
+#endif
+    classify_bytes_from(data, i, size, separators, punctuation);
+}
+
+// First position in [from, to) whose bit equals set, to if there is none
+inline size_t find_bit(const std::vector<uint64_t> &bits, size_t from, size_t to, bool set)
+{
+    while (from < to)
+    {
+        uint64_t word = set ? bits[from / 64] : ~bits[from / 64];
+        word &= ~uint64_t(0) << (from % 64);
+        if (word != 0)
+        {
+            size_t found = from / 64 * 64 + __builtin_ctzll(word);
+            return found < to ? found : to;
+        }
+        from = from / 64 * 64 + 64;
+    }
+    return to;
+}
+
+// Position after the last one in [from, to) whose bit equals set, from if there is none
+inline size_t find_bit_back(const std::vector<uint64_t> &bits, size_t from, size_t to, bool set)
+{
+    while (to > from)
+    {
+        size_t last = to - 1;
+        uint64_t word = set ? bits[last / 64] : ~bits[last / 64];
+        word &= ~uint64_t(0) >> (63 - last % 64);
+        if (word != 0)
+        {
+            size_t found = last / 64 * 64 + 63 - __builtin_clzll(word);
+            return found >= from ? found + 1 : from;
+        }
+        to = last / 64 * 64;
+    }
+    return from;
+}
+
+/**
+ * @brief reads whitespace separated words from stream and calls fn(word) for every word that is not empty
+ * after normalization. The stream is read in blocks, lowercasing and the classification of separators and
+ * punctuation run over a whole block at once, words and their punctuation are then found by bit scans
+ *
+ * @param is stream words are read from
+ * @param mode is combination of word_normalization steps
+ * @param fn is function called with every normalized word, the word buffer is reused between calls
+ */
+template <typename Fn>
+void read_normalized_words(std::istream &is, word_normalization mode, Fn fn)
+{
+    std::vector<char> buffer(1 << 16);
+    std::vector<uint64_t> separators, punctuation;
+    bool strip = mode & normalize_strip_punctuation;
+    // Word continuing in the next block, it is stripped as a whole when it ends
+    std::string word;
+
+    auto emit = [&word, &fn, mode]()
+    {
+        normalize_word(word, word_normalization(mode & normalize_strip_punctuation));
+        if (!word.empty())
+        {
+            fn(word);
+        }
+        word.clear();
+    };
+
+    while (is.read(buffer.data(), buffer.size()) || is.gcount() > 0)
+    {
+        size_t size = is.gcount();
+        if (mode & normalize_lowercase)
+        {
+            ascii_lowercase(buffer.data(), size);
+        }
+        classify_bytes(buffer.data(), size, separators, punctuation);
+
+        size_t i = 0;
+        if (!word.empty())
+        {
+            i = find_bit(separators, 0, size, true);
+            word.append(buffer.data(), i);
+            if (i == size)
+            {
+                continue;
+            }
+            emit();
+        }
+        while (true)
+        {
+            size_t start = find_bit(separators, i, size, false);
+            if (start == size)
+            {
+                break;
+            }
+            i = find_bit(separators, start, size, true);
+            if (i == size)
+            {
+                word.assign(buffer.data() + start, size - start);
+                break;
+            }
+            size_t stop = i;
+            if (strip)
+            {
+                start = find_bit(punctuation, start, stop, false);
+                stop = find_bit_back(punctuation, start, stop, false);
+            }
+            if (start < stop)
+            {
+                word.assign(buffer.data() + start, stop - start);
+                fn(word);
+                word.clear();
+            }
+        }
+    }
+    if (!word.empty())
+    {
+        emit();
+    }
+}
@@ -0,0 +1,71 @@
+#include <memory>
+#include <utility>
+#pragma once
+using namespace std;
+
+/**
+ * @brief container shared by its copies until one of them is modified, e.g. copy_on_write<BiRing<Key, Info>>
+ *
+ * Copies share one container through a reference count, so copying is O(1). write() clones the container
+ * first when other copies still share it, so a writer never changes what the other copies see.
+ * read() and operator-> give the const container, whose iterators give only const keys and infos.
+ * A container passed as an rvalue is moved in without copying its elements.
+ * References and iterators taken through write() must not be used after the wrapper was copied again.
+ * Copies must not be modified concurrently from several threads.
+ *
+ * The sharing is done by the wrapper, Sequence and BiRing copied directly still copy every node.
+ * filter_shared, join_shared, shuffle_shared and split_shared of bi_ring.h and split_pos and split_key
+ * of split.hpp with copy_on_write outputs give shared results.
+ */
+template <typename Container>
+class copy_on_write
+{
+private:
+    shared_ptr<Container> data;
+
+public:
+    copy_on_write() : data(make_shared<Container>()) {}
+    copy_on_write(const Container &container) : data(make_shared<Container>(container)) {}
+    copy_on_write(Container &&container) : data(make_shared<Container>(std::move(container))) {}
+    // Moves share too, a moved-from wrapper stays usable
+    copy_on_write(const copy_on_write &) = default;
+    copy_on_write &operator=(const copy_on_write &) = default;
+
+    /**
+     * @brief container for reading, shared with other copies
+     */
+    const Container &read() const
+    {
+        return *data;
+    }
+
+    const Container &operator*() const
+    {
+        return *data;
+    }
+
+    const Container *operator->() const
+    {
+        return data.get();
+    }
+
+    /**
+     * @brief container for modification, cloned first if other copies share it
+     */
+    Container &write()
+    {
+        if (data.use_count() != 1)
+        {
+            data = make_shared<Container>(*data);
+        }
+        return *data;
+    }
+
+    /**
+     * @brief checks if other copies share the container
+     */
+    bool shared() const
+    {
+        return data.use_count() > 1;
+    }
+};
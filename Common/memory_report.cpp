@@ -0,0 +1,95 @@
+// Prints memory used per element by Sequence, BiRing and avl_tree filled with the standard test fixtures
+//
+// Build: g++ -std=c++17 -O2 memory_report.cpp -o memory_report
+// Run from this directory, word count fixtures are read from ../AVL
+
+#include "../SingleLinkedList/Sequence.hpp"
+#include "../Ring/bi_ring.h"
+#include "../AVL/avl_tree.h"
+
+#include <string>
+
+using namespace std;
+
+void print_row(const string &name, const memory_stats &stats)
+{
+    cout << left << setw(56) << name << right << setw(10) << stats.elements << setw(12) << stats.node_bytes
+         << setw(12) << stats.allocator_overhead << setw(12) << stats.payload_bytes << setw(12) << stats.total()
+         << setw(12) << fixed << setprecision(1) << stats.bytes_per_element() << "\n";
+}
+
+void sequence_report()
+{
+    // Fixture of split_pos tests
+    Sequence<int, int> numbers;
+    for (int i = 0; i < 25; ++i)
+    {
+        numbers.push_back(i, i);
+    }
+    print_row("Sequence<int, int> split fixture", numbers.memory_usage());
+
+    Sequence<int, string> names;
+    names.push_back(1, "One");
+    names.push_back(2, "Two");
+    names.push_back(3, "Three");
+    print_row("Sequence<int, string> print fixture", names.memory_usage());
+
+    Sequence<int, int> large;
+    for (int i = 0; i < 100000; ++i)
+    {
+        large.push_back(i, i);
+    }
+    print_row("Sequence<int, int> 100000 elements", large.memory_usage());
+}
+
+void ring_report()
+{
+    // Fixture of unique tests
+    BiRing<int, string> translations;
+    string infos_fr[] = {"un", "deux", "trois", "quatre", "cinq", "six", "sept", "huit", "neuf", "dix"};
+    string infos_en[] = {"one", "two", "three", "four", "five", "six", "seven", "eight", "nine", "ten"};
+    for (int i = 0; i < 10; i++)
+    {
+        translations.push_back(i + 1, infos_fr[i]);
+        translations.push_back(i + 1, infos_en[i]);
+    }
+    print_row("BiRing<int, string> unique fixture", translations.memory_usage());
+
+    BiRing<int, int> large;
+    for (int i = 0; i < 100000; ++i)
+    {
+        large.push_back(i, i);
+    }
+    print_row("BiRing<int, int> 100000 elements", large.memory_usage());
+}
+
+void tree_report()
+{
+    for (const string file : {"Vagner_song.txt", "Ukraine_Gimn.txt", "Soviet_union_gimn.txt", "bandera.txt", "beagle_voyage.txt"})
+    {
+        ifstream is("../AVL/" + file);
+        if (!is)
+        {
+            cerr << "Can not open ../AVL/" << file << endl;
+            continue;
+        }
+        print_row("avl_tree<string, int> count_words " + file, count_words(is).memory_usage());
+    }
+
+    avl_tree<int, int> large;
+    for (int i = 0; i < 100000; ++i)
+    {
+        large.insert(i, i);
+    }
+    print_row("avl_tree<int, int> 100000 elements", large.memory_usage());
+}
+
+int main()
+{
+    cout << left << setw(56) << "container" << right << setw(10) << "elements" << setw(12) << "nodes"
+         << setw(12) << "overhead" << setw(12) << "payload" << setw(12) << "total" << setw(12) << "B/element" << "\n";
+    sequence_report();
+    ring_report();
+    tree_report();
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <cstddef>
+#include <string>
+#include <utility>
+#pragma once
+
+/**
+ * @brief memory used by a container, reported by memory_usage() of Sequence, BiRing and avl_tree
+ *
+ */
+struct memory_stats
+{
+    size_t elements = 0;
+    // sizeof the container object and all of its nodes
+    size_t node_bytes = 0;
+    // estimated bookkeeping and rounding of the allocator behind node allocations
+    size_t allocator_overhead = 0;
+    // heap memory owned by keys and infos, as reported by heap_bytes
+    size_t payload_bytes = 0;
+
+    size_t total() const
+    {
+        return node_bytes + allocator_overhead + payload_bytes;
+    }
+
+    double bytes_per_element() const
+    {
+        return elements == 0 ? 0 : (double)total() / elements;
+    }
+};
+
+/**
+ * @brief estimated overhead of a malloc allocation, modelled on 64 bit glibc:
+ * 8 bytes of chunk header, chunks rounded up to 16 bytes and never smaller than 32 bytes
+ *
+ * @param bytes requested size
+ * @return size_t bytes used on top of the requested size
+ */
+inline size_t allocation_overhead(size_t bytes)
+{
+    size_t chunk = (bytes + 8 + 15) & ~(size_t)15;
+    if (chunk < 32)
+    {
+        chunk = 32;
+    }
+    return chunk - bytes;
+}
+
+/**
+ * @brief customization point, heap memory owned by value beyond its sizeof including allocator overhead.
+ * Types owning heap memory overload it next to their definition, it is found by argument dependent lookup
+ *
+ * @return size_t 0 for types that own no heap memory
+ */
+template <typename T>
+size_t heap_bytes(const T &)
+{
+    return 0;
+}
+
+inline size_t heap_bytes(const std::string &str)
+{
+    // Short strings are stored inside the object itself
+    const char *object = reinterpret_cast<const char *>(&str);
+    if (str.data() >= object && str.data() < object + sizeof(str))
+    {
+        return 0;
+    }
+    return str.capacity() + 1 + allocation_overhead(str.capacity() + 1);
+}
+
+template <typename First, typename Second>
+size_t heap_bytes(const std::pair<First, Second> &pair)
+{
+    return heap_bytes(pair.first) + heap_bytes(pair.second);
+}
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#pragma once
+using namespace std;
+
+/**
+ * @brief text export of container elements through a reusable buffer, used by export_text() of Sequence, BiRing and avl_tree
+ *
+ * Elements are written as "[(key, info), (key, info)]". Numbers are formatted with to_chars in the form
+ * operator<< gives them with the precision of the stream, strings are copied, other types go through operator<<.
+ * The buffer is written with one write() whenever it fills up and when the exporter is flushed or destroyed,
+ * so any number of elements is exported with capacity bytes of memory.
+ *
+ * Streaming: open(), any number of element() calls and close() export elements that are not in a container,
+ * e.g. while they are produced.
+ */
+class text_exporter
+{
+private:
+    ostream &os;
+    vector<char> buffer;
+    size_t used = 0;
+    bool first = true; // no element written since open()
+    int precision;
+    ostringstream fallback; // formats types without to_chars
+
+    static constexpr size_t numberRoom = 64;
+
+    // Makes room for bytes characters, returns where they are written
+    char *room(size_t bytes)
+    {
+        if (used + bytes > buffer.size())
+        {
+            flush();
+        }
+        return buffer.data() + used;
+    }
+
+    template <typename T>
+    static constexpr bool character_v = is_same_v<T, char> || is_same_v<T, signed char> || is_same_v<T, unsigned char>;
+
+public:
+    explicit text_exporter(ostream &os, size_t capacity = 1 << 16)
+        : os(os), buffer(std::max(capacity, 2 * numberRoom)), precision(static_cast<int>(os.precision()))
+    {
+        fallback.copyfmt(os);
+    }
+
+    text_exporter(const text_exporter &) = delete;
+    text_exporter &operator=(const text_exporter &) = delete;
+
+    ~text_exporter()
+    {
+        flush();
+    }
+
+    /**
+     * @brief writes buffered text to the stream
+     */
+    void flush()
+    {
+        if (used > 0)
+        {
+            os.write(buffer.data(), used);
+            used = 0;
+        }
+    }
+
+    size_t buffered() const
+    {
+        return used;
+    }
+
+    text_exporter &write(char c)
+    {
+        *room(1) = c;
+        used++;
+        return *this;
+    }
+
+    text_exporter &write(string_view text)
+    {
+        if (text.size() > buffer.size() - used)
+        {
+            flush();
+            if (text.size() >= buffer.size())
+            {
+                // Longer than the whole buffer, copying it first would not save a write
+                os.write(text.data(), text.size());
+                return *this;
+            }
+        }
+        memcpy(buffer.data() + used, text.data(), text.size());
+        used += text.size();
+        return *this;
+    }
+
+    /**
+     * @brief writes value as operator<< would print it
+     */
+    template <typename T>
+    text_exporter &value(const T &value)
+    {
+        if constexpr (is_same_v<T, bool>)
+        {
+            return write(value ? '1' : '0');
+        }
+        else if constexpr (character_v<T>)
+        {
+            return write(static_cast<char>(value));
+        }
+        else if constexpr (is_arithmetic_v<T>)
+        {
+            char *first = room(numberRoom);
+            to_chars_result result;
+            if constexpr (is_integral_v<T>)
+            {
+                result = to_chars(first, first + numberRoom, value);
+            }
+            else
+            {
+                result = to_chars(first, first + numberRoom, value, chars_format::general, precision);
+            }
+            if (result.ec == errc())
+            {
+                used = result.ptr - buffer.data();
+                return *this;
+            }
+            // Precision of the stream does not fit the room, let the stream format it
+        }
+        else if constexpr (is_convertible_v<const T &, string_view>)
+        {
+            return write(string_view(value));
+        }
+        fallback.str("");
+        fallback << value;
+        return write(string_view(fallback.str()));
+    }
+
+    /**
+     * @brief starts the list of elements
+     */
+    void open()
+    {
+        write('[');
+        first = true;
+    }
+
+    template <typename Key, typename Info>
+    void element(const Key &key, const Info &info)
+    {
+        if (!first)
+        {
+            write(", ");
+        }
+        first = false;
+        write('(');
+        value(key);
+        write(", ");
+        value(info);
+        write(')');
+    }
+
+    /**
+     * @brief ends the list of elements, the text stays in the buffer until the next flush
+     */
+    void close()
+    {
+        write(']');
+    }
+};
+
+/**
+ * @brief writes all elements of container to os, with a buffer used only for this export
+ */
+template <typename Container>
+void export_text(ostream &os, const Container &container)
+{
+    text_exporter out(os);
+    container.export_text(out);
+}
@@ -0,0 +1,65 @@
+#include <utility>
+#include <type_traits>
+#pragma once
+using namespace std;
+
+/**
+ * @brief element of Sequence or BiRing as seen through the STL iterators of elements()
+ *
+ * Keys and infos are stored in nodes separately, so dereferencing gives this proxy instead of a reference
+ * to a pair. it->key and it->info reach the node, converting the proxy to a pair copies the element.
+ */
+template <typename Key, typename Info>
+struct element_ref
+{
+    Key &key;
+    Info &info;
+
+    operator pair<remove_const_t<Key>, remove_const_t<Info>>() const
+    {
+        return {key, info};
+    }
+
+    // Lets iterators return the proxy from operator->
+    element_ref *operator->()
+    {
+        return this;
+    }
+};
+
+// Number of links traversal helpers walk ahead of the visited node, loading nodes before they are needed
+constexpr unsigned int prefetch_distance = 4;
+
+inline void prefetch_node(const void *node)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(node);
+#else
+    (void)node;
+#endif
+}
+
+/**
+ * @brief calls visit(node) for nodes from first until next(node) is last, prefetching nodes prefetch_distance links ahead
+ *
+ * @param next returns the node following the given one
+ */
+template <typename Node, typename Next, typename Visit>
+void visit_prefetched(Node *first, Node *last, Next next, Visit visit)
+{
+    Node *ahead = first;
+    for (unsigned int i = 0; i < prefetch_distance && ahead != last; i++)
+    {
+        ahead = next(ahead);
+    }
+    for (Node *node = first; node != last; node = next(node))
+    {
+        if (ahead != last)
+        {
+            // ahead was prefetched in the previous step, its successor is requested now
+            ahead = next(ahead);
+            prefetch_node(ahead);
+        }
+        visit(node);
+    }
+}
@@ -1,19 +1,30 @@
 #include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
 #include <vector>
+#include "../Common/copy_on_write.h"
+#include "../Common/memory_usage.h"
+#include "../Common/text_export.h"
+#include "../Common/traversal.h"
 #pragma once
 using namespace std;
 
-template <typename Key, typename Info>
+template <typename Key, typename Info, bool PositionIndexed = false>
 class BiRing;
 
-template <typename Key, typename Info>
-ostream &operator<<(ostream &os, const BiRing<Key, Info> &ring)
+template <typename Key, typename Info, bool PositionIndexed>
+ostream &operator<<(ostream &os, const BiRing<Key, Info, PositionIndexed> &ring)
 {
     os << "[";
+    auto last = --ring.cend();
     for (auto it = ring.cbegin(); it != ring.cend(); it.next())
     {
         os << "(" << it.key() << ", " << it.info() << ")";
-        if (it != --ring.cend())
+        if (it != last)
         {
             os << ", ";
         }
@@ -23,11 +34,45 @@ ostream &operator<<(ostream &os, const BiRing<Key, Info> &ring)
     return os;
 };
 
-template <typename Key, typename Info>
+// Links of a node in the order-statistic tree over ring nodes, present only in rings with position index
+template <typename NodeType, bool Enabled>
+struct order_field
+{
+};
+
+template <typename NodeType>
+struct order_field<NodeType, true>
+{
+    NodeType *left = nullptr;
+    NodeType *right = nullptr;
+    NodeType *parent = nullptr;
+    unsigned int size = 1;     // nodes in the subtree
+    unsigned int priority = 0; // heap order of the treap, parents have higher priorities
+};
+
+// Root of the order-statistic tree, a treap keyed by position in the ring
+template <typename NodeType>
+struct order_tree
+{
+    NodeType *root = nullptr;
+    unsigned int seed = 0x9e3779b9u;
+};
+
+struct no_order_index
+{
+};
+
+/**
+ * @brief doubly linked ring with a sentinel
+ *
+ * @tparam PositionIndexed keeps an order-statistic tree over the nodes, so it + k, it - k and at(k) take
+ * O(log n) expected time, inserts and erases O(log n) instead of O(1)
+ */
+template <typename Key, typename Info, bool PositionIndexed>
 class BiRing
 {
 private:
-    class Node
+    class Node : public order_field<Node, PositionIndexed>
     {
     private:
         Node *next;
@@ -43,18 +88,40 @@ private:
         friend class BiRing;
     };
 
-    template <typename KeyType, typename InfoType, typename RingType>
+    // Iterator going round the ring, it skips the sentinel. Checked iterators throw runtime_error when used null,
+    // unchecked ones (Checked = false) only assert it, release builds (NDEBUG) check nothing
+    template <typename KeyType, typename InfoType, typename RingType, bool Checked = true>
     class Iterator
     {
     private:
         friend class BiRing;
+        template <typename, typename, typename, bool>
+        friend class Iterator;
 
         Node *ptr;
         const RingType &ring;
 
         Iterator(Node *ptr, const RingType &ring) : ptr(ptr), ring(ring) {}
 
+        void check() const
+        {
+            if constexpr (Checked)
+            {
+                if (ptr == nullptr)
+                {
+                    throw std::runtime_error("Iterator is null");
+                }
+            }
+            else
+            {
+                assert(ptr != nullptr && "Iterator is null");
+            }
+        }
+
     public:
+        Iterator(const Iterator &src) = default;
+        Iterator(const Iterator<KeyType, InfoType, RingType, !Checked> &src) : ptr(src.ptr), ring(src.ring) {}
+
         bool operator==(const Iterator &other) const
         {
             return ptr == other.ptr;
@@ -76,6 +143,10 @@ private:
 
         Iterator operator+(int steps) const
         {
+            if constexpr (RingType::position_indexed)
+            {
+                return ring.jump(*this, steps, true);
+            }
             Iterator result = *this;
             for (int i = 0; i < steps % ring.length; ++i)
             {
@@ -86,6 +157,10 @@ private:
 
         Iterator operator-(int steps) const
         {
+            if constexpr (RingType::position_indexed)
+            {
+                return ring.jump(*this, steps, false);
+            }
             Iterator result = *this;
             for (int i = 0; i < steps % ring.length; ++i)
             {
@@ -144,38 +219,26 @@ private:
 
         Iterator next()
         {
-            if (ptr == nullptr)
-            {
-                throw std::runtime_error("Iterator is null");
-            }
+            check();
             ptr = ptr->next;
             return *this;
         }
 
         Iterator get_next()
         {
-            if (ptr == nullptr)
-            {
-                throw std::runtime_error("Iterator is null");
-            }
+            check();
             return Iterator(ptr->next, ring);
         }
 
         Iterator get_prev()
         {
-            if (ptr == nullptr)
-            {
-                throw std::runtime_error("Iterator is null");
-            }
+            check();
             return Iterator(ptr->prev, ring);
         }
 
         Iterator prev()
         {
-            if (ptr == nullptr)
-            {
-                throw std::runtime_error("Iterator is null");
-            }
+            check();
 
             ptr = ptr->prev;
             return *this;
@@ -183,19 +246,379 @@ private:
 
         KeyType &key() const
         {
+            check();
             return ptr->key;
         }
 
         InfoType &info() const
         {
+            check();
             return ptr->info;
         }
     };
 
+    // Bidirectional iterator of elements(). It stops at the sentinel instead of skipping it, so the sentinel is the end.
+    // Unchecked: use of a null iterator is only asserted, release builds (NDEBUG) check nothing
+    template <typename KeyType, typename InfoType>
+    class ElementIterator
+    {
+    private:
+        friend class BiRing;
+        template <typename, typename>
+        friend class ElementIterator;
+
+        Node *ptr;
+
+        explicit ElementIterator(Node *ptr) : ptr(ptr) {}
+
+    public:
+        using iterator_category = bidirectional_iterator_tag;
+        using value_type = pair<Key, Info>;
+        using difference_type = ptrdiff_t;
+        using reference = element_ref<KeyType, InfoType>;
+        using pointer = element_ref<KeyType, InfoType>;
+
+        ElementIterator() : ptr(nullptr) {}
+
+        // Modifying iterators convert to constant ones
+        template <typename K, typename I, typename = enable_if_t<is_const_v<KeyType> && !is_const_v<K>>>
+        ElementIterator(const ElementIterator<K, I> &other) : ptr(other.ptr) {}
+
+        bool operator==(const ElementIterator &other) const
+        {
+            return ptr == other.ptr;
+        }
+
+        bool operator!=(const ElementIterator &other) const
+        {
+            return ptr != other.ptr;
+        }
+
+        reference operator*() const
+        {
+            assert(ptr != nullptr && "Iterator is null");
+            return {ptr->key, ptr->info};
+        }
+
+        pointer operator->() const
+        {
+            return **this;
+        }
+
+        ElementIterator &operator++()
+        {
+            assert(ptr != nullptr && "Iterator is null");
+            ptr = ptr->next;
+            return *this;
+        }
+
+        ElementIterator operator++(int)
+        {
+            assert(ptr != nullptr && "Iterator is null");
+            ElementIterator temp = *this;
+            ptr = ptr->next;
+            return temp;
+        }
+
+        ElementIterator &operator--()
+        {
+            assert(ptr != nullptr && "Iterator is null");
+            ptr = ptr->prev;
+            return *this;
+        }
+
+        ElementIterator operator--(int)
+        {
+            assert(ptr != nullptr && "Iterator is null");
+            ElementIterator temp = *this;
+            ptr = ptr->prev;
+            return temp;
+        }
+    };
+
+    template <typename iterator>
+    struct Range
+    {
+        iterator first;
+        iterator last;
+
+        iterator begin() const
+        {
+            return first;
+        }
+        iterator end() const
+        {
+            return last;
+        }
+    };
+
     unsigned int length;
 
     Node *sentinel;
 
+    conditional_t<PositionIndexed, order_tree<Node>, no_order_index> order;
+
+    static unsigned int tree_size(const Node *node)
+    {
+        return node == nullptr ? 0 : node->size;
+    };
+
+    void update_size(Node *node)
+    {
+        node->size = 1 + tree_size(node->left) + tree_size(node->right);
+    };
+
+    // Moves node above its parent, keeping the in-order sequence of nodes
+    void rotate_up(Node *node)
+    {
+        Node *parent = node->parent;
+        Node *grandparent = parent->parent;
+        if (node == parent->left)
+        {
+            parent->left = node->right;
+            if (node->right != nullptr)
+            {
+                node->right->parent = parent;
+            }
+            node->right = parent;
+        }
+        else
+        {
+            parent->right = node->left;
+            if (node->left != nullptr)
+            {
+                node->left->parent = parent;
+            }
+            node->left = parent;
+        }
+        parent->parent = node;
+        node->parent = grandparent;
+        if (grandparent == nullptr)
+        {
+            order.root = node;
+        }
+        else if (grandparent->left == parent)
+        {
+            grandparent->left = node;
+        }
+        else
+        {
+            grandparent->right = node;
+        }
+        update_size(parent);
+        update_size(node);
+    };
+
+    // Adds node to the tree right before position, after the last node when position is the sentinel
+    void tree_insert_before(Node *node, Node *position)
+    {
+        order.seed ^= order.seed << 13;
+        order.seed ^= order.seed >> 17;
+        order.seed ^= order.seed << 5;
+        node->priority = order.seed;
+        node->left = node->right = nullptr;
+        node->size = 1;
+
+        Node *parent = nullptr;
+        if (order.root == nullptr)
+        {
+            order.root = node;
+        }
+        else if (position != sentinel && position->left == nullptr)
+        {
+            parent = position;
+            parent->left = node;
+        }
+        else
+        {
+            // Predecessor of position is the last node of its left subtree, or of the whole tree
+            parent = position == sentinel ? order.root : position->left;
+            while (parent->right != nullptr)
+            {
+                parent = parent->right;
+            }
+            parent->right = node;
+        }
+        node->parent = parent;
+        for (Node *ancestor = parent; ancestor != nullptr; ancestor = ancestor->parent)
+        {
+            ancestor->size++;
+        }
+        while (node->parent != nullptr && node->parent->priority < node->priority)
+        {
+            rotate_up(node);
+        }
+    };
+
+    void tree_erase(Node *node)
+    {
+        // Rotate node down to a leaf, children with higher priority go up
+        while (node->left != nullptr || node->right != nullptr)
+        {
+            Node *child = node->left == nullptr                                              ? node->right
+                          : node->right == nullptr || node->left->priority > node->right->priority ? node->left
+                                                                                                 : node->right;
+            rotate_up(child);
+        }
+        Node *parent = node->parent;
+        if (parent == nullptr)
+        {
+            order.root = nullptr;
+            return;
+        }
+        (parent->left == node ? parent->left : parent->right) = nullptr;
+        for (Node *ancestor = parent; ancestor != nullptr; ancestor = ancestor->parent)
+        {
+            ancestor->size--;
+        }
+    };
+
+    // 0-based position of an element node
+    unsigned int rank_of(const Node *node) const
+    {
+        if constexpr (PositionIndexed)
+        {
+            unsigned int rank = tree_size(node->left);
+            for (; node->parent != nullptr; node = node->parent)
+            {
+                if (node == node->parent->right)
+                {
+                    rank += tree_size(node->parent->left) + 1;
+                }
+            }
+            return rank;
+        }
+        unsigned int rank = 0;
+        for (Node *current = sentinel->next; current != node; current = current->next)
+        {
+            rank++;
+        }
+        return rank;
+    };
+
+    // Node at 0-based position, the sentinel if there is no such element
+    Node *node_at(unsigned int position) const
+    {
+        if (position >= length)
+        {
+            return sentinel;
+        }
+        if constexpr (PositionIndexed)
+        {
+            Node *node = order.root;
+            while (true)
+            {
+                unsigned int left = tree_size(node->left);
+                if (position < left)
+                {
+                    node = node->left;
+                }
+                else if (position == left)
+                {
+                    return node;
+                }
+                else
+                {
+                    position -= left + 1;
+                    node = node->right;
+                }
+            }
+        }
+        Node *node = sentinel->next;
+        for (; position > 0; position--)
+        {
+            node = node->next;
+        }
+        return node;
+    };
+
+    // it + steps or it - steps through the tree, the same element stepping one by one would reach
+    template <typename iterator>
+    iterator jump(const iterator &from, int steps, bool forward) const
+    {
+        if (length == 0)
+        {
+            return from;
+        }
+        unsigned int count = static_cast<unsigned int>(steps) % length;
+        if (count == 0)
+        {
+            return from;
+        }
+        unsigned int rank;
+        if (from.ptr == sentinel)
+        {
+            rank = forward ? count - 1 : length - count;
+        }
+        else
+        {
+            unsigned int current = rank_of(from.ptr);
+            rank = forward ? (current + count) % length : (current + length - count) % length;
+        }
+        return iterator(node_at(rank), *this);
+    }
+
+    // Relinks count nodes of other from first till before last to before position
+    void transfer(Node *position, BiRing &other, Node *first, Node *last, unsigned int count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        Node *lastMoved = last->prev;
+        if constexpr (PositionIndexed)
+        {
+            for (Node *node = first; node != last; node = node->next)
+            {
+                other.tree_erase(node);
+            }
+        }
+
+        first->prev->next = last;
+        last->prev = first->prev;
+
+        first->prev = position->prev;
+        position->prev->next = first;
+        lastMoved->next = position;
+        position->prev = lastMoved;
+
+        other.length -= count;
+        length += count;
+        if constexpr (PositionIndexed)
+        {
+            for (Node *node = first; node != position; node = node->next)
+            {
+                tree_insert_before(node, position);
+            }
+        }
+    };
+
+    void link_before(Node *node, Node *position)
+    {
+        node->next = position;
+        node->prev = position->prev;
+        position->prev->next = node;
+        position->prev = node;
+
+        length++;
+        if constexpr (PositionIndexed)
+        {
+            tree_insert_before(node, position);
+        }
+    };
+
+    void unlink(Node *node)
+    {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        if constexpr (PositionIndexed)
+        {
+            tree_erase(node);
+        }
+
+        length--;
+    };
+
     template <typename iterator>
     bool find(iterator &it, const Key &key,
               iterator search_from,
@@ -214,11 +637,93 @@ private:
             }
         }
         return false;
-    };
+    }
+
+    template <typename iterator>
+    vector<iterator> collect_all(const Key &key) const
+    {
+        vector<iterator> found;
+        for (Node *node = sentinel->next; node != sentinel; node = node->next)
+        {
+            if (node->key == key)
+            {
+                found.push_back(iterator(node, *this));
+            }
+        }
+        return found;
+    }
 
 public:
+    static constexpr bool position_indexed = PositionIndexed;
+
     typedef Iterator<Key, Info, BiRing> modifying_iterator;
     typedef Iterator<const Key, const Info, BiRing> constant_iterator;
+    // Same iterators with null checks only asserted, for hot loops. Converted from and to the checked ones
+    typedef Iterator<Key, Info, BiRing, false> unchecked_iterator;
+    typedef Iterator<const Key, const Info, BiRing, false> const_unchecked_iterator;
+
+    typedef ElementIterator<Key, Info> element_iterator;
+    typedef ElementIterator<const Key, const Info> const_element_iterator;
+
+    /**
+     * @brief element removed from a ring by extract(), owned by the handle until it is inserted again.
+     * key() and info() of an empty handle throw runtime_error
+     */
+    class node_handle
+    {
+    private:
+        Node *node = nullptr;
+
+        explicit node_handle(Node *node) : node(node) {}
+
+        void check() const
+        {
+            if (node == nullptr)
+            {
+                throw std::runtime_error("Node handle is empty");
+            }
+        }
+
+        friend class BiRing;
+
+    public:
+        node_handle() = default;
+        node_handle(node_handle &&src) : node(src.node)
+        {
+            src.node = nullptr;
+        }
+        node_handle &operator=(node_handle &&src)
+        {
+            if (this != &src)
+            {
+                delete node;
+                node = src.node;
+                src.node = nullptr;
+            }
+            return *this;
+        }
+        ~node_handle()
+        {
+            delete node;
+        }
+
+        bool empty() const
+        {
+            return node == nullptr;
+        }
+
+        Key &key() const
+        {
+            check();
+            return node->key;
+        }
+
+        Info &info() const
+        {
+            check();
+            return node->info;
+        }
+    };
 
     BiRing() : length(0)
     {
@@ -233,6 +738,15 @@ public:
         sentinel->prev = sentinel;
         *this = src;
     };
+    // Takes over the nodes of src, src is left empty with a sentinel of its own. Iterators of src stay bound to src
+    BiRing(BiRing &&src) : length(src.length), sentinel(src.sentinel), order(src.order)
+    {
+        src.sentinel = new Node(Key(), Info(), nullptr, nullptr);
+        src.sentinel->next = src.sentinel;
+        src.sentinel->prev = src.sentinel;
+        src.length = 0;
+        src.order = decltype(order)();
+    };
     ~BiRing()
     {
         clear();
@@ -252,6 +766,15 @@ public:
         }
         return *this;
     };
+    // Exchanges nodes with src, the previous elements of this ring are destroyed with src
+    BiRing &operator=(BiRing &&src) noexcept
+    {
+        std::swap(length, src.length);
+        std::swap(sentinel, src.sentinel);
+        std::swap(order, src.order);
+        return *this;
+    };
+
 
     /**
      * @brief Get the Length of ring
@@ -263,6 +786,41 @@ public:
         return length;
     };
 
+    /**
+     * @brief memory used by the ring, sentinel included
+     *
+     * @return memory_stats sizes of nodes, estimated allocator overhead and heap memory owned by keys and infos
+     */
+    memory_stats memory_usage() const
+    {
+        memory_stats stats;
+        stats.elements = length;
+        stats.node_bytes = sizeof(*this) + (length + 1) * sizeof(Node);
+        stats.allocator_overhead = (length + 1) * allocation_overhead(sizeof(Node));
+        Node *node = sentinel;
+        do
+        {
+            stats.payload_bytes += heap_bytes(node->key) + heap_bytes(node->info);
+            node = node->next;
+        } while (node != sentinel);
+        return stats;
+    };
+
+    /**
+     * @brief writes all elements to out, in the same text operator<< prints
+     *
+     * @param out exporter, its buffer can be shared by several exports
+     */
+    void export_text(text_exporter &out) const
+    {
+        out.open();
+        for (Node *node = sentinel->next; node != sentinel; node = node->next)
+        {
+            out.element(node->key, node->info);
+        }
+        out.close();
+    };
+
     /**
      * Checks if ring is empty
      *
@@ -286,16 +844,82 @@ public:
     modifying_iterator insert(constant_iterator position, const Key &key, const Info &info)
     {
         Node *newNode = new Node(key, info, nullptr, nullptr);
+        link_before(newNode, position.ptr);
+        return modifying_iterator(newNode, *this);
+    }
 
-        Node *positionNode = position.ptr;
-        newNode->next = positionNode;
-        newNode->prev = positionNode->prev;
-        positionNode->prev->next = newNode;
-        positionNode->prev = newNode;
+    /**
+     * @brief inserts extracted element before position, without allocating or copying it
+     *
+     * @param node handle returned by extract() of this or another ring of the same type, empty afterwards
+     * @return iterator pointing on inserted element, end() if the handle was empty
+     */
+    modifying_iterator insert(constant_iterator position, node_handle &&node)
+    {
+        if (node.empty())
+        {
+            return end();
+        }
+        Node *inserted = node.node;
+        node.node = nullptr;
+        link_before(inserted, position.ptr);
+        return modifying_iterator(inserted, *this);
+    }
 
-        length++;
+    /**
+     * @brief removes element from the ring without destroying it
+     *
+     * @return handle owning the element, to be inserted into this or another ring. Empty if position is cend()
+     */
+    node_handle extract(constant_iterator position)
+    {
+        if (position == cend())
+        {
+            return node_handle();
+        }
+        Node *extracted = position.ptr;
+        unlink(extracted);
+        return node_handle(extracted);
+    }
 
-        return modifying_iterator(newNode, *this);
+    /**
+     * @brief moves elements [first, last) of other before position, relinking the nodes without allocating or copying
+     *
+     * O(number of moved elements) to count them, O(log n) per element to update the position index.
+     * other may be this ring if position is not in [first, last). Iterators of other pointing on moved elements
+     * stay bound to other and must not be used after the splice, the returned iterator is bound to this ring
+     *
+     * @param first iterator of other pointing on the first moved element
+     * @param last iterator of other pointing after the last moved element, other.cend() to move till the end.
+     * Elements are taken in order from first, the range does not go round the ring
+     * @return iterator pointing on the first moved element, position if nothing was moved
+     */
+    modifying_iterator splice(constant_iterator position, BiRing &other, constant_iterator first, constant_iterator last)
+    {
+        unsigned int count = 0;
+        for (Node *node = first.ptr; node != last.ptr; node = node->next)
+        {
+            count++;
+        }
+        transfer(position.ptr, other, first.ptr, last.ptr, count);
+        return modifying_iterator(count == 0 ? position.ptr : first.ptr, *this);
+    }
+
+    /**
+     * @brief moves all elements of other before position, O(1) without position index.
+     * Iterators of other must not be used after the splice
+     *
+     * @return iterator pointing on the first moved element, position if other was empty
+     */
+    modifying_iterator splice(constant_iterator position, BiRing &other)
+    {
+        Node *first = other.sentinel->next;
+        if (&other == this || first == other.sentinel)
+        {
+            return modifying_iterator(position.ptr, *this);
+        }
+        transfer(position.ptr, other, first, other.sentinel, other.length);
+        return modifying_iterator(first, *this);
     }
 
     /**
@@ -315,13 +939,9 @@ public:
         Node *eraseNode = position.ptr;
         Node *nextNode = eraseNode->next;
 
-        eraseNode->prev->next = eraseNode->next;
-        eraseNode->next->prev = eraseNode->prev;
-
+        unlink(eraseNode);
         delete eraseNode;
 
-        length--;
-
         return modifying_iterator(nextNode, *this);
     };
 
@@ -386,6 +1006,86 @@ public:
         return counter;
     };
 
+    /**
+     * @brief all elements as a range of bidirectional iterators, from the first element to the sentinel
+     *
+     * @return range usable in range-for, std::for_each, std::count_if, ...
+     */
+    Range<element_iterator> elements()
+    {
+        return {element_iterator(sentinel->next), element_iterator(sentinel)};
+    };
+    Range<const_element_iterator> elements() const
+    {
+        return {const_element_iterator(sentinel->next), const_element_iterator(sentinel)};
+    };
+
+    /**
+     * @brief iterator pointing on the same element as it, for insert and erase
+     */
+    constant_iterator position(const_element_iterator it) const
+    {
+        return constant_iterator(it.ptr, *this);
+    };
+
+    /**
+     * @brief calls fn(key, info) for every element in order, nodes are prefetched a few links ahead
+     */
+    template <typename Fn>
+    void for_each(Fn fn)
+    {
+        visit_prefetched(sentinel->next, sentinel, [](Node *node)
+                         { return node->next; }, [&fn](Node *node)
+                         { fn(node->key, node->info); });
+    }
+    template <typename Fn>
+    void for_each(Fn fn) const
+    {
+        visit_prefetched(sentinel->next, sentinel, [](Node *node)
+                         { return node->next; }, [&fn](const Node *node)
+                         { fn(node->key, node->info); });
+    }
+
+    /**
+     * @brief iterators pointing on all elements of a given key, collected in one traversal
+     *
+     * @param key is key which occurrences we look for
+     * @return vector of iterators in ring order, empty if key is not in the ring
+     */
+    vector<modifying_iterator> find_all(const Key &key)
+    {
+        return collect_all<modifying_iterator>(key);
+    };
+    vector<constant_iterator> find_all(const Key &key) const
+    {
+        return collect_all<constant_iterator>(key);
+    };
+
+    /**
+     * @brief iterator pointing on element at given position, counted from 0
+     * O(log n) with position index, O(position) otherwise
+     *
+     * @return iterator pointing on the element, cend() if position is not less than length
+     */
+    constant_iterator at(unsigned int position) const
+    {
+        return constant_iterator(node_at(position), *this);
+    };
+    modifying_iterator at(unsigned int position)
+    {
+        return modifying_iterator(node_at(position), *this);
+    };
+
+    /**
+     * @brief position of element, counted from 0. O(log n) with position index, O(position) otherwise
+     *
+     * @param it iterator pointing on an element, not on cend()
+     */
+    unsigned int index_of(constant_iterator it) const
+    {
+        return rank_of(it.ptr);
+    };
+
     /**
      * @brief inserts element in the beginning of the ring
      *
@@ -488,8 +1188,38 @@ BiRing<Key, Info> filter(const BiRing<Key, Info> &source, bool (*pred)(const Key
     return result;
 }
 
+// Keys with std::hash are aggregated through a hash table, other keys by searching
+template <typename Key>
+constexpr bool hashable_key = is_default_constructible_v<hash<Key>>;
+
+// Keys with operator<, sorted rings of them are joined by merging
+template <typename Key, typename = void>
+struct comparable_key : false_type
+{
+};
+template <typename Key>
+struct comparable_key<Key, void_t<decltype(declval<const Key &>() < declval<const Key &>())>> : true_type
+{
+};
+
+// Adds occurrence of key to result of unique or join, aggregated points on infos of keys already in result
+template <typename Key, typename Info, typename Aggregate>
+void aggregate_occurrence(BiRing<Key, Info> &result, unordered_map<Key, Info *> &aggregated, const Key &key, const Info &info, Aggregate aggregate)
+{
+    auto found = aggregated.find(key);
+    if (found == aggregated.end())
+    {
+        aggregated.emplace(key, &result.push_back(key, info).info());
+    }
+    else
+    {
+        *found->second = aggregate(key, *found->second, info);
+    }
+}
+
+// O(n^2) unique for keys without std::hash
 template <typename Key, typename Info>
-BiRing<Key, Info> unique(const BiRing<Key, Info> &src, Info (*aggregate)(const Key &, const Info &, const Info &))
+BiRing<Key, Info> unique_by_search(const BiRing<Key, Info> &src, Info (*aggregate)(const Key &, const Info &, const Info &))
 {
     BiRing<Key, Info> result;
 
@@ -517,20 +1247,208 @@ BiRing<Key, Info> unique(const BiRing<Key, Info> &src, Info (*aggregate)(const K
     return result;
 }
 
+/**
+ * @brief ring with one element per key of src, in order of first occurrences. Info of an element is
+ * aggregate applied from left to right to infos of all occurrences of its key
+ * Expected O(n) for keys with std::hash, O(n^2) otherwise
+ */
+template <typename Key, typename Info>
+BiRing<Key, Info> unique(const BiRing<Key, Info> &src, Info (*aggregate)(const Key &, const Info &, const Info &))
+{
+    if constexpr (hashable_key<Key>)
+    {
+        BiRing<Key, Info> result;
+        unordered_map<Key, Info *> aggregated;
+        aggregated.reserve(src.getLength());
+        src.for_each([&](const Key &key, const Info &info)
+                     { aggregate_occurrence(result, aggregated, key, info, aggregate); });
+        return result;
+    }
+    else
+    {
+        return unique_by_search(src, aggregate);
+    }
+}
+
+/**
+ * @brief unique() with the ring split into contiguous ranges aggregated by threads in parallel, one pass over
+ * the elements in total. Tables of the ranges are merged in order of the ranges, so keys keep the order of
+ * first occurrences. Unlike unique(), infos of a key are aggregated per range and the results of ranges are
+ * aggregated together, so aggregate must be associative to give the result of unique(), and it must be safe
+ * to call from several threads. Pays off for very large rings only
+ *
+ * @param threads number of threads, unique() is used for 1
+ */
+template <typename Key, typename Info>
+BiRing<Key, Info> unique_parallel(const BiRing<Key, Info> &src, Info (*aggregate)(const Key &, const Info &, const Info &), unsigned int threads)
+{
+    if constexpr (!hashable_key<Key>)
+    {
+        return unique_by_search(src, aggregate);
+    }
+    else
+    {
+        if (threads <= 1 || src.getLength() < threads)
+        {
+            return unique(src, aggregate);
+        }
+
+        // Range t starts at starts[t] and ends at starts[t + 1], the last one at cend()
+        typedef typename BiRing<Key, Info>::const_unchecked_iterator range_iterator;
+        vector<range_iterator> starts;
+        starts.reserve(threads + 1);
+        size_t length = src.getLength();
+        size_t position = 0;
+        for (range_iterator it = src.cbegin(); starts.size() < threads; it.next(), position++)
+        {
+            if (position == starts.size() * length / threads)
+            {
+                starts.push_back(it);
+            }
+        }
+        starts.push_back(src.cend());
+
+        // Every range keeps its keys in order of first occurrences in it
+        vector<vector<pair<Key, Info>>> ranges(threads);
+        vector<thread> workers;
+        for (unsigned int t = 0; t < threads; t++)
+        {
+            workers.emplace_back([&, t]()
+                                 {
+                vector<pair<Key, Info>> &aggregated = ranges[t];
+                unordered_map<Key, size_t> slots;
+                slots.reserve((t + 1) * length / threads - t * length / threads);
+                for (range_iterator it = starts[t]; it != starts[t + 1]; it.next())
+                {
+                    auto found = slots.find(it.key());
+                    if (found == slots.end())
+                    {
+                        slots.emplace(it.key(), aggregated.size());
+                        aggregated.emplace_back(it.key(), it.info());
+                    }
+                    else
+                    {
+                        Info &info = aggregated[found->second].second;
+                        info = aggregate(it.key(), info, it.info());
+                    }
+                } });
+        }
+        for (thread &worker : workers)
+        {
+            worker.join();
+        }
+
+        BiRing<Key, Info> result;
+        unordered_map<Key, Info *> aggregated;
+        aggregated.reserve(length);
+        for (vector<pair<Key, Info>> &range : ranges)
+        {
+            for (pair<Key, Info> &element : range)
+            {
+                aggregate_occurrence(result, aggregated, element.first, element.second, aggregate);
+            }
+        }
+        return result;
+    }
+}
+
 template <typename Key, typename Info>
 Info sum_info(const Key &, const Info &i1, const Info &i2)
 {
     return i1 + i2;
 }
+// Join of key-sorted rings in one merging pass. Keys found only in second follow all keys of first
+template <typename Key, typename Info>
+BiRing<Key, Info> join_sorted(const BiRing<Key, Info> &first, const BiRing<Key, Info> &second)
+{
+    BiRing<Key, Info> result;
+    vector<pair<Key, Info>> only_second;
+    auto first_elements = first.elements();
+    auto second_elements = second.elements();
+    auto first_it = first_elements.begin();
+    auto second_it = second_elements.begin();
+
+    // Aggregates infos of the run of equal keys starting at it
+    auto take_run = [](auto &it, const auto &end, const Key &key, Info &info)
+    {
+        for (; it != end && !(key < it->key); ++it)
+        {
+            info = sum_info(key, info, it->info);
+        }
+    };
+    auto take_only_second = [&]()
+    {
+        const Key &key = second_it->key;
+        Info info = second_it->info;
+        ++second_it;
+        take_run(second_it, second_elements.end(), key, info);
+        only_second.emplace_back(key, info);
+    };
+
+    while (first_it != first_elements.end())
+    {
+        const Key &key = first_it->key;
+        Info info = first_it->info;
+        ++first_it;
+        take_run(first_it, first_elements.end(), key, info);
+        while (second_it != second_elements.end() && second_it->key < key)
+        {
+            take_only_second();
+        }
+        take_run(second_it, second_elements.end(), key, info);
+        result.push_back(key, info);
+    }
+    while (second_it != second_elements.end())
+    {
+        take_only_second();
+    }
+    for (const auto &element : only_second)
+    {
+        result.push_back(element.first, element.second);
+    }
+    return result;
+}
+
+/**
+ * @brief ring with one element per key of first and second, in order of first occurrences in first followed
+ * by second. Infos of all occurrences of a key are summed in this order
+ * Key-sorted rings are merged, other rings aggregated through a hash table, both without concatenating them
+ */
 template <typename Key, typename Info>
 BiRing<Key, Info> join(const BiRing<Key, Info> &first, const BiRing<Key, Info> &second)
 {
-    BiRing<Key, Info> pre_result = first;
-    for (auto it = second.cbegin(); it != second.cend(); it.next())
+    if constexpr (comparable_key<Key>::value)
     {
-        pre_result.push_back(it.key(), it.info());
+        auto by_key = [](const auto &a, const auto &b)
+        { return a.key < b.key; };
+        auto first_elements = first.elements();
+        auto second_elements = second.elements();
+        if (is_sorted(first_elements.begin(), first_elements.end(), by_key) &&
+            is_sorted(second_elements.begin(), second_elements.end(), by_key))
+        {
+            return join_sorted(first, second);
+        }
+    }
+    if constexpr (hashable_key<Key>)
+    {
+        BiRing<Key, Info> result;
+        unordered_map<Key, Info *> aggregated;
+        aggregated.reserve(first.getLength() + second.getLength());
+        auto add = [&](const Key &key, const Info &info)
+        { aggregate_occurrence(result, aggregated, key, info, sum_info<Key, Info>); };
+        first.for_each(add);
+        second.for_each(add);
+        return result;
+    }
+    else
+    {
+        BiRing<Key, Info> pre_result = first;
+        for (auto it = second.cbegin(); it != second.cend(); it.next())
+        {
+            pre_result.push_back(it.key(), it.info());
+        }
+        return unique_by_search(pre_result, sum_info<Key, Info>);
     }
-    return unique(pre_result, sum_info<Key, Info>);
 }
 
 template <typename Key, typename Info>
@@ -566,28 +1484,78 @@ BiRing<Key, Info> shuffle(
 
 // Additional function given in the lab
 
+/**
+ * @brief splits source into runs of elements with increasing infos, moving the nodes of source into the runs
+ */
 template <typename Key, typename Info>
-vector<BiRing<Key, Info>> split(const BiRing<Key, Info> &source)
+vector<BiRing<Key, Info>> split(BiRing<Key, Info> &&source)
 {
-    vector<BiRing<Key, Info>> result;
-    BiRing<Key, Info> current = BiRing<Key, Info>();
-    current.push_back(source.cbegin().key(), source.cbegin().info());
-    for (auto it = source.cbegin().get_next(); it != source.cend(); it.next())
+    typedef typename BiRing<Key, Info>::constant_iterator constant_iterator;
+    const BiRing<Key, Info> &view = source;
+    vector<constant_iterator> starts;
+    for (auto it = view.cbegin(); it != view.cend(); it.next())
     {
-
-        if ((--current.cend()).info() < it.info())
-        {
-
-            current.push_back(it.key(), it.info());
-        }
-        else
+        if (starts.empty() || !(it.get_prev().info() < it.info()))
         {
-            result.push_back(current);
-            current = BiRing<Key, Info>();
-            current.push_back(it.key(), it.info());
+            starts.push_back(it);
         }
     }
-    result.push_back(current);
 
+    vector<BiRing<Key, Info>> result(starts.size());
+    for (size_t i = 0; i < starts.size(); i++)
+    {
+        auto last = i + 1 < starts.size() ? starts[i + 1] : view.cend();
+        result[i].splice(result[i].cend(), source, starts[i], last);
+    }
+
+    return result;
+}
+
+template <typename Key, typename Info>
+vector<BiRing<Key, Info>> split(const BiRing<Key, Info> &source)
+{
+    return split(BiRing<Key, Info>(source));
+}
+
+// Same functions with results shared copy-on-write: the result is moved into the wrapper, copies of it
+// share the ring in O(1) and a ring is cloned only when one of its copies is written
+
+template <typename Key, typename Info>
+copy_on_write<BiRing<Key, Info>> filter_shared(const BiRing<Key, Info> &source, bool (*pred)(const Key &))
+{
+    return copy_on_write<BiRing<Key, Info>>(filter(source, pred));
+}
+
+template <typename Key, typename Info>
+copy_on_write<BiRing<Key, Info>> join_shared(const BiRing<Key, Info> &first, const BiRing<Key, Info> &second)
+{
+    return copy_on_write<BiRing<Key, Info>>(join(first, second));
+}
+
+template <typename Key, typename Info>
+copy_on_write<BiRing<Key, Info>> shuffle_shared(
+    const BiRing<Key, Info> &first, unsigned int fcnt,
+    const BiRing<Key, Info> &second, unsigned int scnt,
+    unsigned int reps)
+{
+    return copy_on_write<BiRing<Key, Info>>(shuffle(first, fcnt, second, scnt, reps));
+}
+
+template <typename Key, typename Info>
+vector<copy_on_write<BiRing<Key, Info>>> split_shared(BiRing<Key, Info> &&source)
+{
+    vector<BiRing<Key, Info>> runs = split(std::move(source));
+    vector<copy_on_write<BiRing<Key, Info>>> result;
+    result.reserve(runs.size());
+    for (BiRing<Key, Info> &run : runs)
+    {
+        result.emplace_back(std::move(run));
+    }
     return result;
+}
+
+template <typename Key, typename Info>
+vector<copy_on_write<BiRing<Key, Info>>> split_shared(const BiRing<Key, Info> &source)
+{
+    return split_shared(BiRing<Key, Info>(source));
 }
\ No newline at end of file
@@ -1,10 +1,13 @@
 #include "bi_ring.h"
 #include "bi_ring_test.h"
+#include "../Common/copy_on_write.h"
 
 #include <iostream>
 #include <cassert>
 #include <algorithm>
 #include <sstream>
+#include <chrono>
+#include <cstdlib>
 
 using namespace std;
 
@@ -463,6 +466,207 @@ void occurrencesOf_test()
     cout << "OccurrencesOf tests passed" << endl;
 }
 
+void find_all_test()
+{
+    BiRing<int, std::string> ring;
+    for (int i = 0; i < 10; i++)
+    {
+        ring.push_back(i % 3, std::to_string(i));
+    }
+
+    const BiRing<int, std::string> &constRing = ring;
+    auto found = constRing.find_all(1);
+    assert(found.size() == 3);
+    assert(found[0].info() == "1" && found[1].info() == "4" && found[2].info() == "7");
+
+    // Iterators are used for positional work without searching again
+    ring.insert(found[1], 5, "inserted");
+    ring.erase(found[2]);
+    assert(ring.occurrencesOf(1) == 2 && ring.getLength() == 10);
+    auto it = ring.cbegin();
+    for (int i = 0; i < 4; i++)
+    {
+        it.next();
+    }
+    assert(it.key() == 5 && it.info() == "inserted");
+
+    auto modifiable = ring.find_all(0);
+    assert(modifiable.size() == 4 && modifiable[3].info() == "9");
+    modifiable[0].info() = "zero";
+    assert(ring.cbegin().info() == "zero");
+    assert(ring.find_all(42).empty());
+
+    BiRing<int, int> empty;
+    assert(empty.find_all(0).empty());
+
+    cout << "Find all test passed" << endl;
+}
+
+void unchecked_iterator_test()
+{
+    BiRing<int, int> ring;
+    for (int i = 0; i < 10; i++)
+    {
+        ring.push_back(i, i * 10);
+    }
+
+    // Unchecked iterators go round the ring the same way, skipping the sentinel
+    BiRing<int, int>::unchecked_iterator it = ring.begin();
+    int sum = 0;
+    for (int i = 0; i < 25; i++, it++)
+    {
+        sum += it.info();
+    }
+    assert(sum == 2 * 450 + 100 && it.key() == 5);
+    it = it - 7;
+    assert(it.key() == 8);
+    it.info() = -1;
+    assert((ring.begin() + 8).info() == -1);
+
+    // Converted back for functions taking checked iterators
+    const BiRing<int, int> &constRing = ring;
+    BiRing<int, int>::const_unchecked_iterator position = constRing.cbegin();
+    position++;
+    ring.insert(position, 100, 100);
+    assert(ring.cbegin().get_next().key() == 100 && ring.getLength() == 11);
+    BiRing<int, int>::constant_iterator checked = position;
+    ring.erase(checked);
+    assert(ring.getLength() == 10 && ring.cbegin().get_next().key() == 100);
+
+    cout << "Unchecked iterator tests passed" << endl;
+}
+
+void elements_test()
+{
+    BiRing<int, std::string> ring;
+    for (int i = 0; i < 10; i++)
+    {
+        ring.push_back(i, std::to_string(i * i));
+    }
+
+    // std algorithms stop at the sentinel
+    auto elements = ring.elements();
+    assert(std::distance(elements.begin(), elements.end()) == 10);
+    assert(std::count_if(elements.begin(), elements.end(), [](const std::pair<int, std::string> &element)
+                         { return element.first % 2 == 0; }) == 5);
+    auto found = std::find_if(elements.begin(), elements.end(), [](auto element)
+                              { return element.info == "49"; });
+    assert(found->key == 7);
+    std::for_each(elements.begin(), elements.end(), [](auto element)
+                  { element.info += "!"; });
+
+    int sum = 0;
+    for (auto element : ring.elements())
+    {
+        sum += element.key;
+    }
+    assert(sum == 45);
+
+    // Backwards with reverse iterators
+    const BiRing<int, std::string> &constRing = ring;
+    auto constElements = constRing.elements();
+    auto last = std::make_reverse_iterator(constElements.end());
+    assert(last->key == 9 && (*last).info == "81!");
+    std::pair<int, std::string> copied = *++last;
+    assert(copied.first == 8 && copied.second == "64!");
+
+    // Found element is erased through a ring iterator
+    ring.erase(ring.position(found));
+    assert(ring.getLength() == 9 && ring.occurrencesOf(7) == 0);
+
+    int visited = 0;
+    constRing.for_each([&visited](const int &key, const std::string &)
+                       { visited += key; });
+    assert(visited == 38);
+
+    BiRing<int, int> empty;
+    assert(empty.elements().begin() == empty.elements().end());
+
+    cout << "Elements test passed" << endl;
+}
+
+template <typename Key, typename Info>
+void assert_same_ring(const BiRing<Key, Info> &expected, const BiRing<Key, Info> &actual)
+{
+    assert(expected.getLength() == actual.getLength());
+    auto it = expected.cbegin();
+    for (auto element : actual.elements())
+    {
+        assert(element.key == it.key() && element.info == it.info());
+        it.next();
+    }
+}
+
+bool is_even(const int &key)
+{
+    return key % 2 == 0;
+}
+
+void copy_on_write_test()
+{
+    BiRing<int, std::string> ring;
+    for (int i = 0; i < 5; i++)
+    {
+        ring.push_back(i, std::to_string(i));
+    }
+
+    copy_on_write<BiRing<int, std::string>> original(filter(ring, is_even));
+    copy_on_write<BiRing<int, std::string>> copy = original;
+    assert(copy.shared() && original.shared());
+    assert(&copy.read() == &original.read() && copy->getLength() == 3);
+
+    // Writer gets its own ring, the other copy keeps seeing the old one
+    copy.write().push_back(6, "6");
+    assert(!copy.shared() && !original.shared());
+    assert(copy->getLength() == 4 && original->getLength() == 3);
+    assert((--original->cend()).key() == 4);
+
+    // Not shared, no clone
+    const BiRing<int, std::string> *before = &copy.read();
+    copy.write().pop_front();
+    assert(&copy.read() == before && copy->getLength() == 3);
+
+    copy_on_write<BiRing<int, std::string>> moved = std::move(copy);
+    assert(copy->getLength() == 3 && moved.shared());
+
+    // Rings are moved into the wrapper, their nodes are not copied
+    BiRing<int, std::string> evens = filter(ring, is_even);
+    const int *first_key = &evens.cbegin().key();
+    BiRing<int, std::string> taken(std::move(evens));
+    assert(&taken.cbegin().key() == first_key && evens.isEmpty());
+    evens.push_back(1, "1");
+    evens = std::move(taken);
+    assert(&evens.cbegin().key() == first_key && evens.getLength() == 3 && taken.getLength() == 1);
+    copy_on_write<BiRing<int, std::string>> wrapped(std::move(evens));
+    assert(&wrapped->cbegin().key() == first_key && evens.isEmpty());
+
+    // Results of filter, join, shuffle and split come shared, their copies share the ring
+    auto shared_evens = filter_shared(ring, is_even);
+    auto shared_copy = shared_evens;
+    assert(shared_copy.shared() && &shared_copy.read() == &shared_evens.read());
+    assert_same_ring(filter(ring, is_even), shared_evens.read());
+    assert_same_ring(join(ring, ring), join_shared(ring, ring).read());
+    assert_same_ring(shuffle(ring, 2, ring, 1, 3), shuffle_shared(ring, 2, ring, 1, 3).read());
+    ring.push_back(1, "1");
+    auto runs = split(ring);
+    auto shared_runs = split_shared(ring);
+    assert(runs.size() == 2 && shared_runs.size() == 2);
+    std::vector<copy_on_write<BiRing<int, std::string>>> run_copies = shared_runs;
+    for (size_t i = 0; i < runs.size(); i++)
+    {
+        assert_same_ring(runs[i], shared_runs[i].read());
+        assert(&run_copies[i].read() == &shared_runs[i].read());
+    }
+    run_copies[0].write().clear();
+    assert(shared_runs[0]->getLength() == 5);
+
+    // Readers only get const keys and infos
+    static_assert(std::is_const_v<std::remove_reference_t<decltype(wrapped.read().cbegin().info())>>);
+    static_assert(std::is_const_v<std::remove_reference_t<decltype(wrapped->elements().begin()->info)>>);
+
+    cout << "Copy on write test passed" << endl;
+}
+
 void print_test()
 {
     // Create a sequence
@@ -482,6 +686,43 @@ void print_test()
     std::cout << "Print Ring test passed!" << std::endl;
 }
 
+void export_text_test()
+{
+    BiRing<int, std::string> ring;
+    ring.push_back(1, "One");
+    ring.push_back(2, "Two");
+    ring.push_back(3, "Three");
+
+    // Same text as operator<<
+    ostringstream printed, exported;
+    printed << ring;
+    export_text(exported, ring);
+    assert(exported.str() == printed.str());
+
+    // One exporter streams several rings, its buffer is flushed when full
+    BiRing<char, long long> big;
+    for (int i = 0; i < 500; i++)
+    {
+        big.push_back('a' + i % 26, -1000000000000LL * i);
+    }
+    ostringstream bigPrinted, streamed;
+    bigPrinted << big << ring;
+    {
+        text_exporter out(streamed, 100);
+        big.export_text(out);
+        ring.export_text(out);
+        assert(out.buffered() < 200);
+    }
+    assert(streamed.str() == bigPrinted.str());
+
+    BiRing<int, int> empty;
+    ostringstream none;
+    export_text(none, empty);
+    assert(none.str() == "[]");
+
+    std::cout << "Export text test passed!" << std::endl;
+}
+
 bool aboba(const std::string &str)
 {
     return str.size() > 3;
@@ -574,6 +815,39 @@ void unique_test()
     cout << "Unique test passed" << endl;
 }
 
+void unique_hash_test()
+{
+    BiRing<int, std::string> source;
+    srand(3);
+    for (int i = 0; i < 3000; i++)
+    {
+        source.push_back(rand() % 200, std::to_string(i));
+    }
+
+    // Hash aggregation gives the result of the search with the same order of aggregation, parallel ranges
+    // give it too for the associative concatenation
+    auto expected = unique_by_search(source, _concatenate_info<int, std::string>);
+    assert_same_ring(expected, unique(source, _concatenate_info<int, std::string>));
+    for (unsigned threads : {1u, 2u, 3u, 8u})
+    {
+        assert_same_ring(expected, unique_parallel(source, _concatenate_info<int, std::string>, threads));
+    }
+
+    // Keys without std::hash are still searched
+    BiRing<std::pair<int, char>, std::string> pairs;
+    pairs.push_back({1, 'a'}, "A");
+    pairs.push_back({2, 'b'}, "B");
+    pairs.push_back({1, 'a'}, "C");
+    auto merged = unique_parallel(pairs, _concatenate_info<std::pair<int, char>, std::string>, 4);
+    assert(merged.getLength() == 2 && merged.cbegin().info() == "A-C");
+
+    BiRing<int, std::string> empty;
+    assert(unique(empty, _concatenate_info<int, std::string>).isEmpty());
+    assert(unique_parallel(empty, _concatenate_info<int, std::string>, 4).isEmpty());
+
+    cout << "Unique hash test passed" << endl;
+}
+
 void join_test()
 {
     BiRing<int, std::string> ring1;
@@ -599,6 +873,59 @@ void join_test()
     cout << "Join test passed" << endl;
 }
 
+// Join as concatenation followed by unique, the definition join has to keep
+template <typename Key, typename Info>
+BiRing<Key, Info> join_by_concatenation(const BiRing<Key, Info> &first, const BiRing<Key, Info> &second)
+{
+    BiRing<Key, Info> concatenation = first;
+    for (auto it = second.cbegin(); it != second.cend(); it.next())
+    {
+        concatenation.push_back(it.key(), it.info());
+    }
+    return unique_by_search(concatenation, sum_info<Key, Info>);
+}
+
+void fast_join_test()
+{
+    // Unsorted rings, hash aggregation
+    BiRing<int, std::string> first, second;
+    srand(9);
+    for (int i = 0; i < 500; i++)
+    {
+        first.push_back(rand() % 100, std::to_string(i));
+        second.push_back(rand() % 150, "s" + std::to_string(i));
+    }
+    assert_same_ring(join_by_concatenation(first, second), join(first, second));
+
+    // Sorted rings, merging
+    BiRing<int, std::string> sorted_first, sorted_second;
+    for (int i = 0; i < 300; i++)
+    {
+        sorted_first.push_back(i / 3 * 2, std::to_string(i));
+        sorted_second.push_back(i / 2, "s" + std::to_string(i));
+    }
+    assert_same_ring(join_by_concatenation(sorted_first, sorted_second), join(sorted_first, sorted_second));
+    assert_same_ring(join_by_concatenation(sorted_second, sorted_first), join(sorted_second, sorted_first));
+
+    // Keys without std::hash, sorted and unsorted
+    BiRing<std::pair<int, char>, int> pairs1, pairs2;
+    pairs1.push_back({1, 'a'}, 1);
+    pairs1.push_back({2, 'b'}, 2);
+    pairs2.push_back({0, 'z'}, 10);
+    pairs2.push_back({2, 'b'}, 20);
+    pairs2.push_back({3, 'c'}, 30);
+    assert_same_ring(join_by_concatenation(pairs1, pairs2), join(pairs1, pairs2));
+    pairs1.push_back({0, 'z'}, 3);
+    assert_same_ring(join_by_concatenation(pairs1, pairs2), join(pairs1, pairs2));
+
+    BiRing<int, std::string> empty;
+    assert(join(empty, empty).isEmpty());
+    assert_same_ring(unique(first, sum_info<int, std::string>), join(empty, first));
+    assert(join(sorted_first, empty).getLength() == 100);
+
+    cout << "Fast join test passed" << endl;
+}
+
 void shuffle_test()
 {
     BiRing<std::string, int> first;
@@ -691,6 +1018,391 @@ void split_test()
 
     cout << "Split test passed" << endl;
 }
+void memory_usage_test()
+{
+    BiRing<int, std::string> ring;
+    memory_stats empty = ring.memory_usage();
+    assert(empty.elements == 0);
+    // Sentinel is always there
+    assert(empty.node_bytes > sizeof(ring));
+
+    ring.push_back(1, "one");
+    ring.push_back(2, std::string(64, 'x'));
+    memory_stats stats = ring.memory_usage();
+    assert(stats.elements == 2);
+    assert(stats.node_bytes > empty.node_bytes);
+    assert(stats.payload_bytes == heap_bytes(std::string(64, 'x')));
+    assert(stats.bytes_per_element() > 0);
+
+    cout << "Memory usage test passed" << endl;
+}
+
+void position_index_test()
+{
+    BiRing<int, int> plain;
+    BiRing<int, int, true> indexed;
+    assert(indexed.at(0) == indexed.end());
+    srand(11);
+    int next_key = 0;
+    for (int step = 0; step < 20000; step++)
+    {
+        unsigned int length = plain.getLength();
+        int operation = rand() % 4;
+        if (operation < 2 || length == 0)
+        {
+            unsigned int position = rand() % (length + 1);
+            const BiRing<int, int> &plain_view = plain;
+            const BiRing<int, int, true> &indexed_view = indexed;
+            plain.insert(plain_view.at(position), next_key, step);
+            indexed.insert(indexed_view.at(position), next_key, step);
+            next_key++;
+        }
+        else if (operation == 2)
+        {
+            unsigned int position = rand() % length;
+            const BiRing<int, int> &plain_view = plain;
+            const BiRing<int, int, true> &indexed_view = indexed;
+            assert(indexed_view.index_of(indexed_view.at(position)) == position);
+            plain.erase(plain_view.at(position));
+            indexed.erase(indexed_view.at(position));
+        }
+        else
+        {
+            // Jumps from an element or from end(), both ways, by any number of steps
+            unsigned int position = rand() % (length + 1);
+            int steps = rand() % (3 * length) - static_cast<int>(length);
+            auto plain_from = plain.at(position);
+            auto indexed_from = indexed.at(position);
+            auto plain_forward = plain_from + steps;
+            auto indexed_forward = indexed_from + steps;
+            auto plain_backward = plain_from - steps;
+            auto indexed_backward = indexed_from - steps;
+            assert((plain_forward == plain.end()) == (indexed_forward == indexed.end()));
+            assert((plain_backward == plain.end()) == (indexed_backward == indexed.end()));
+            if (plain_forward != plain.end())
+            {
+                assert(plain_forward.key() == indexed_forward.key());
+            }
+            if (plain_backward != plain.end())
+            {
+                assert(plain_backward.key() == indexed_backward.key());
+            }
+        }
+        assert(plain.getLength() == indexed.getLength());
+    }
+
+    BiRing<int, int, true> copy = indexed;
+    auto plain_it = plain.cbegin();
+    for (unsigned int i = 0; i < plain.getLength(); i++, plain_it++)
+    {
+        assert(indexed.at(i).key() == plain_it.key());
+        assert(copy.at(i).key() == plain_it.key());
+    }
+    assert(copy.at(copy.getLength()) == copy.end());
+    indexed.clear();
+    assert(indexed.at(0) == indexed.end());
+    indexed.push_front(1, 1);
+    indexed.push_front(2, 2);
+    indexed.push_back(3, 3);
+    assert(indexed.at(0).key() == 2 && indexed.at(1).key() == 1 && indexed.at(2).key() == 3);
+    assert((indexed.begin() - 1).key() == 3);
+
+    cout << "Position index tests passed" << endl;
+}
+
+template <typename Ring>
+long long jump_keys(Ring &ring, int jumps)
+{
+    long long sum = 0;
+    auto it = ring.begin();
+    for (int i = 0; i < jumps; i++)
+    {
+        it = it + (rand() % ring.getLength());
+        sum += it.key();
+    }
+    return sum;
+}
+
+void jump_time_measurement()
+{
+    BiRing<int, int> plain;
+    BiRing<int, int, true> indexed;
+    for (int i = 0; i < 100000; i++)
+    {
+        plain.push_back(i, i);
+        indexed.push_back(i, i);
+    }
+
+    srand(5);
+    auto start_time = std::chrono::high_resolution_clock::now();
+    long long plain_sum = jump_keys(plain, 1000);
+    auto plain_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    srand(5);
+    start_time = std::chrono::high_resolution_clock::now();
+    long long indexed_sum = jump_keys(indexed, 1000);
+    auto indexed_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert(plain_sum == indexed_sum);
+
+    start_time = std::chrono::high_resolution_clock::now();
+    BiRing<int, int> plain_filled;
+    for (int i = 0; i < 100000; i++)
+    {
+        plain_filled.push_back(i, i);
+    }
+    auto plain_fill_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    BiRing<int, int, true> indexed_filled;
+    for (int i = 0; i < 100000; i++)
+    {
+        indexed_filled.push_back(i, i);
+    }
+    auto indexed_fill_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    cout << "1000 random jumps in 100000 elements: stepping " << plain_time / std::chrono::microseconds(1)
+         << "us, position index " << indexed_time / std::chrono::microseconds(1) << "us" << endl;
+    cout << "100000 push_back: plain " << plain_fill_time / std::chrono::microseconds(1)
+         << "us, position index " << indexed_fill_time / std::chrono::microseconds(1) << "us" << endl;
+}
+
+template <bool PositionIndexed>
+void check_splice()
+{
+    BiRing<int, int, PositionIndexed> first, second;
+    for (int i = 0; i < 10; i++)
+    {
+        first.push_back(i, i);
+        second.push_back(100 + i, i);
+    }
+    const BiRing<int, int, PositionIndexed> &first_view = first, &second_view = second;
+
+    // [102, 105) of second before 3 of first
+    first.splice(first_view.at(3), second, second_view.at(2), second_view.at(5));
+    assert(first.getLength() == 13 && second.getLength() == 7);
+    int expected_first[] = {0, 1, 2, 102, 103, 104, 3, 4, 5, 6, 7, 8, 9};
+    for (unsigned int i = 0; i < first.getLength(); i++)
+    {
+        assert(first.at(i).key() == expected_first[i]);
+    }
+    int expected_second[] = {100, 101, 105, 106, 107, 108, 109};
+    auto second_it = second.cbegin();
+    for (unsigned int i = 0; i < second.getLength(); i++, second_it++)
+    {
+        assert(second_it.key() == expected_second[i]);
+        assert(second.at(i).key() == expected_second[i]);
+    }
+    assert((second.begin() - 1).key() == 109);
+
+    // Tail of second to the end of first, then a range moved inside first
+    second.splice(second_view.cend(), second, second_view.cbegin(), second_view.at(2));
+    assert(second.getLength() == 7 && second.cbegin().key() == 105 && (--second.cend()).key() == 101);
+    first.splice(first_view.cend(), second, second_view.at(5), second_view.cend());
+    first.splice(first_view.cbegin(), first, first_view.at(3), first_view.at(6));
+    int expected_moved[] = {102, 103, 104, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 100, 101};
+    assert(first.getLength() == 15 && second.getLength() == 5);
+    auto first_it = first.cbegin();
+    for (unsigned int i = 0; i < first.getLength(); i++, first_it++)
+    {
+        assert(first_it.key() == expected_moved[i]);
+        assert(first.at(i).key() == expected_moved[i]);
+        assert(first_view.index_of(first_view.at(i)) == i);
+    }
+
+    // Whole ring, then nothing
+    first.splice(first_view.cbegin(), second);
+    assert(first.getLength() == 20 && second.isEmpty());
+    assert(first.at(0).key() == 105 && first.at(5).key() == 102);
+    first.splice(first_view.cbegin(), second);
+    first.splice(first_view.cbegin(), first, first_view.at(4), first_view.at(4));
+    assert(first.getLength() == 20 && (first.begin() + 5).key() == 102);
+
+    // Node handles move elements one by one
+    auto handle = first.extract(first_view.cbegin());
+    assert(!handle.empty() && handle.key() == 105 && first.getLength() == 19);
+    handle.info() = 42;
+    auto inserted = second.insert(second_view.cend(), std::move(handle));
+    assert(handle.empty() && inserted.key() == 105 && inserted.info() == 42);
+    assert(second.getLength() == 1 && second.at(0).key() == 105);
+    assert(first.extract(first_view.cend()).empty());
+    bool thrown = false;
+    try
+    {
+        handle.key();
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(second.insert(second_view.cbegin(), typename BiRing<int, int, PositionIndexed>::node_handle()) == second.end());
+    {
+        // Handle dropped without inserting destroys the element
+        auto dropped = first.extract(first_view.at(3));
+        assert(first.getLength() == 18);
+    }
+    second.clear();
+    first.clear();
+    assert(first.isEmpty());
+
+    // Moved elements are reached through the returned iterator, bound to the ring they were moved to
+    for (int i = 0; i < 10; i++)
+    {
+        second.push_back(100 + i, i);
+    }
+    first.push_back(0, 0);
+    first.push_back(1, 1);
+    auto moved = first.splice(first_view.cend(), second, second_view.cbegin(), second_view.cend());
+    assert(second.isEmpty() && moved.key() == 100);
+    assert((moved + 4).key() == 104 && (moved - 1).key() == 1 && (moved + 10).key() == 0);
+    for (int i = 0; i < 10; i++, moved++)
+    {
+        assert(moved.key() == 100 + i);
+    }
+    assert(moved.key() == 0);
+    assert(first.splice(first_view.cbegin(), second) == first.begin());
+    assert(first.splice(first_view.cend(), second, second_view.cbegin(), second_view.cend()) == first.end());
+    second.push_back(200, 0);
+    assert(first.splice(first_view.at(1), second).key() == 200 && first.at(1).key() == 200);
+    first.clear();
+}
+
+void splice_test()
+{
+    check_splice<false>();
+    check_splice<true>();
+
+    BiRing<int, int> source;
+    int infos[] = {1, 2, 0, 5, 6, 7, 3, 3, 4};
+    for (int i = 0; i < 9; i++)
+    {
+        source.push_back(i, infos[i]);
+    }
+    auto copied = split(source);
+    auto moved = split(std::move(source));
+    assert(source.isEmpty());
+    assert(moved.size() == 4 && copied.size() == 4);
+    for (size_t i = 0; i < moved.size(); i++)
+    {
+        assert_same_ring(copied[i], moved[i]);
+    }
+    assert(moved[1].getLength() == 4 && moved[2].getLength() == 1);
+    assert(split(BiRing<int, int>()).empty());
+
+    cout << "Splice tests passed" << endl;
+}
+
+void unique_time_measurement()
+{
+    BiRing<int, int> ring;
+    srand(5);
+    for (int i = 0; i < 20000; i++)
+    {
+        ring.push_back(rand() % 5000, i);
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto searched = unique_by_search(ring, sum_info<int, int>);
+    auto search_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    auto hashed = unique(ring, sum_info<int, int>);
+    auto hash_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert_same_ring(searched, hashed);
+
+    BiRing<int, int> big;
+    for (int i = 0; i < 2000000; i++)
+    {
+        big.push_back(rand() % 500000, i);
+    }
+    start_time = std::chrono::high_resolution_clock::now();
+    auto sequential = unique(big, sum_info<int, int>);
+    auto sequential_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+    start_time = std::chrono::high_resolution_clock::now();
+    auto parallel = unique_parallel(big, sum_info<int, int>, threads);
+    auto parallel_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert_same_ring(sequential, parallel);
+
+    cout << "unique of " << ring.getLength() << " elements: search " << search_time / std::chrono::milliseconds(1)
+         << "ms, hash " << hash_time / std::chrono::milliseconds(1) << "ms" << endl;
+    cout << "unique of " << big.getLength() << " elements: hash " << sequential_time / std::chrono::milliseconds(1)
+         << "ms, " << threads << " ranges " << parallel_time / std::chrono::milliseconds(1) << "ms" << endl;
+}
+
+void join_time_measurement()
+{
+    BiRing<int, int> small_first, small_second, first, second, sorted_first, sorted_second;
+    srand(7);
+    for (int i = 0; i < 10000; i++)
+    {
+        small_first.push_back(rand() % 5000, i);
+        small_second.push_back(rand() % 5000, i);
+    }
+    for (int i = 0; i < 1000000; i++)
+    {
+        first.push_back(rand() % 500000, i);
+        second.push_back(rand() % 500000, i);
+        sorted_first.push_back(i / 2, i);
+        sorted_second.push_back(i / 3, i);
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto concatenated = join_by_concatenation(small_first, small_second);
+    auto concatenation_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    auto small_joined = join(small_first, small_second);
+    auto small_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert_same_ring(concatenated, small_joined);
+
+    start_time = std::chrono::high_resolution_clock::now();
+    auto hashed = join(first, second);
+    auto hash_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    auto merged = join(sorted_first, sorted_second);
+    auto merge_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert(merged.getLength() == 500000);
+
+    cout << "join of 2 x 10000 elements: concatenation and unique " << concatenation_time / std::chrono::milliseconds(1)
+         << "ms, join " << small_time / std::chrono::milliseconds(1) << "ms" << endl;
+    cout << "join of 2 x 1000000 elements: hash " << hash_time / std::chrono::milliseconds(1)
+         << "ms, sorted merge " << merge_time / std::chrono::milliseconds(1) << "ms" << endl;
+}
+
+void splice_time_measurement()
+{
+    BiRing<int, int> source, copied, spliced;
+    for (int i = 0; i < 1000000; i++)
+    {
+        source.push_back(i, i);
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    while (!source.isEmpty())
+    {
+        copied.push_back(source.cbegin().key(), source.cbegin().info());
+        source.pop_front();
+    }
+    auto copy_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    spliced.splice(spliced.cend(), copied, copied.cbegin(), copied.cend());
+    auto range_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert(spliced.getLength() == 1000000 && copied.isEmpty());
+
+    start_time = std::chrono::high_resolution_clock::now();
+    copied.splice(copied.cend(), spliced);
+    auto whole_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert(copied.getLength() == 1000000 && spliced.isEmpty());
+
+    cout << "moving 1000000 elements: push_back and pop_front " << copy_time / std::chrono::milliseconds(1)
+         << "ms, splice of range " << range_time / std::chrono::microseconds(1)
+         << "us, splice of ring " << whole_time / std::chrono::microseconds(1) << "us" << endl;
+}
+
 int main()
 {
     cout << "Start of tests" << endl;
@@ -712,13 +1424,20 @@ int main()
         iterator_operators_test();
         iterator_decrement_test();
         iterator_increment_test();
+        position_index_test();
+        unchecked_iterator_test();
     }
     {
         // Other tests
         copy_constructor_test();
         find_key_test();
         occurrencesOf_test();
+        find_all_test();
+        elements_test();
+        copy_on_write_test();
         print_test();
+        export_text_test();
+        memory_usage_test();
     }
 
     cout
@@ -728,12 +1447,22 @@ int main()
 
     unique_test();
 
+    unique_hash_test();
+
     join_test();
 
+    fast_join_test();
+
     shuffle_test();
 
     cout << "All external functions tests have passed!" << endl;
 
     // Additional test
     split_test();
-}
\ No newline at end of file
+    splice_test();
+
+    unique_time_measurement();
+    join_time_measurement();
+    jump_time_measurement();
+    splice_time_measurement();
+}
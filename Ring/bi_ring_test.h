@@ -9,11 +9,26 @@ void clear_test();
 void iterator_operators_test();
 void iterator_decrement_test();
 void iterator_increment_test();
+void position_index_test();
+void unchecked_iterator_test();
 void copy_constructor_test();
 void find_key_test();
 void occurrencesOf_test();
+void find_all_test();
+void elements_test();
+void copy_on_write_test();
 void print_test();
+void export_text_test();
+void memory_usage_test();
 
 // additional function test
 
 void split_test();
+void splice_test();
+
+void unique_hash_test();
+void fast_join_test();
+void unique_time_measurement();
+void join_time_measurement();
+void jump_time_measurement();
+void splice_time_measurement();
@@ -0,0 +1,369 @@
+#ifndef CONCURRENT_SEQUENCE_HPP
+#define CONCURRENT_SEQUENCE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief hazard pointers shared by all concurrent sequences
+ *
+ * Every thread owns one record with two hazard slots. A removed node is retired by the thread
+ * that removed it and deleted once no record holds a pointer to it.
+ */
+class hazard_domain
+{
+public:
+    static constexpr unsigned int slotsPerThread = 2;
+
+    struct Record
+    {
+        atomic<void *> hazards[slotsPerThread];
+        atomic<bool> active;
+        Record *next;
+    };
+
+    struct Retired
+    {
+        void *pointer;
+        void (*deleter)(void *);
+    };
+
+private:
+    atomic<Record *> records{nullptr};
+    atomic<unsigned int> recordCount{0};
+
+    // Nodes retired by threads that exited before the nodes could be deleted
+    mutex orphanMutex;
+    vector<Retired> orphans;
+
+    hazard_domain() = default;
+
+public:
+    hazard_domain(const hazard_domain &) = delete;
+    hazard_domain &operator=(const hazard_domain &) = delete;
+
+    ~hazard_domain()
+    {
+        for (const Retired &retired : orphans)
+        {
+            retired.deleter(retired.pointer);
+        }
+        Record *record = records.load();
+        while (record != nullptr)
+        {
+            Record *next = record->next;
+            delete record;
+            record = next;
+        }
+    }
+
+    static hazard_domain &instance()
+    {
+        static hazard_domain domain;
+        return domain;
+    }
+
+    // Takes a free record or adds a new one, records are never removed while the domain lives
+    Record *acquire()
+    {
+        for (Record *record = records.load(); record != nullptr; record = record->next)
+        {
+            bool expected = false;
+            if (!record->active.load() && record->active.compare_exchange_strong(expected, true))
+            {
+                return record;
+            }
+        }
+
+        Record *record = new Record;
+        for (auto &hazard : record->hazards)
+        {
+            hazard.store(nullptr);
+        }
+        record->active.store(true);
+        record->next = records.load();
+        while (!records.compare_exchange_weak(record->next, record))
+        {
+        }
+        recordCount++;
+        return record;
+    }
+
+    void release(Record *record)
+    {
+        for (auto &hazard : record->hazards)
+        {
+            hazard.store(nullptr);
+        }
+        record->active.store(false);
+    }
+
+    // Number of retired nodes after which a thread looks for nodes to delete
+    size_t scanThreshold() const
+    {
+        return std::max<size_t>(64, 2 * slotsPerThread * recordCount.load());
+    }
+
+    // Deletes retired nodes no thread protects, the rest stays in retired
+    void scan(vector<Retired> &retired)
+    {
+        {
+            lock_guard<mutex> lock(orphanMutex);
+            retired.insert(retired.end(), orphans.begin(), orphans.end());
+            orphans.clear();
+        }
+
+        vector<void *> hazards;
+        for (Record *record = records.load(); record != nullptr; record = record->next)
+        {
+            for (auto &hazard : record->hazards)
+            {
+                if (void *pointer = hazard.load())
+                {
+                    hazards.push_back(pointer);
+                }
+            }
+        }
+        sort(hazards.begin(), hazards.end());
+
+        auto kept = std::partition(retired.begin(), retired.end(), [&hazards](const Retired &node)
+                                   { return binary_search(hazards.begin(), hazards.end(), node.pointer); });
+        for (auto it = kept; it != retired.end(); it++)
+        {
+            it->deleter(it->pointer);
+        }
+        retired.erase(kept, retired.end());
+    }
+
+    void adoptOrphans(vector<Retired> &retired)
+    {
+        lock_guard<mutex> lock(orphanMutex);
+        orphans.insert(orphans.end(), retired.begin(), retired.end());
+        retired.clear();
+    }
+};
+
+// Hazard record and retired nodes of the calling thread
+class hazard_thread
+{
+private:
+    hazard_domain &domain;
+    hazard_domain::Record *record;
+    vector<hazard_domain::Retired> retired;
+
+    hazard_thread() : domain(hazard_domain::instance()), record(domain.acquire()) {}
+
+public:
+    ~hazard_thread()
+    {
+        domain.scan(retired);
+        if (!retired.empty())
+        {
+            domain.adoptOrphans(retired);
+        }
+        domain.release(record);
+    }
+
+    static hazard_thread &current()
+    {
+        thread_local hazard_thread thread;
+        return thread;
+    }
+
+    // Publishes pointer read from source in a hazard slot, returns it once it is known to be still there
+    template <typename T>
+    T *protect(unsigned int slot, const atomic<T *> &source)
+    {
+        T *pointer = source.load();
+        while (true)
+        {
+            record->hazards[slot].store(pointer);
+            T *again = source.load();
+            if (again == pointer)
+            {
+                return pointer;
+            }
+            pointer = again;
+        }
+    }
+
+    void set(unsigned int slot, void *pointer)
+    {
+        record->hazards[slot].store(pointer);
+    }
+
+    void clear()
+    {
+        for (auto &hazard : record->hazards)
+        {
+            hazard.store(nullptr);
+        }
+    }
+
+    template <typename T>
+    void retire(T *pointer)
+    {
+        retired.push_back({pointer, [](void *node)
+                           { delete static_cast<T *>(node); }});
+        if (retired.size() >= domain.scanThreshold())
+        {
+            domain.scan(retired);
+        }
+    }
+};
+
+/**
+ * @brief FIFO sequence of elements for many producer and many consumer threads
+ *
+ * push_back and pop_front are lock-free (Michael and Scott queue). Removed nodes are reclaimed
+ * through hazard pointers, so a node is never freed while another thread still reads it.
+ */
+template <typename Key, typename Info>
+class ConcurrentSequence
+{
+private:
+    struct Node
+    {
+        atomic<Node *> next{nullptr};
+        optional<pair<Key, Info>> element; // empty in the dummy node at the front
+
+        Node() = default;
+        template <typename K, typename I>
+        Node(K &&key, I &&info) : element(in_place, std::forward<K>(key), std::forward<I>(info)) {}
+    };
+
+    // Head always points to a dummy node, elements follow it
+    alignas(64) atomic<Node *> head;
+    alignas(64) atomic<Node *> tail;
+
+    void enqueue(Node *node)
+    {
+        hazard_thread &hazards = hazard_thread::current();
+        while (true)
+        {
+            Node *last = hazards.protect(0, tail);
+            Node *next = last->next.load();
+            if (last != tail.load())
+            {
+                continue;
+            }
+            if (next != nullptr)
+            {
+                // Tail is behind, help the other thread to move it
+                tail.compare_exchange_weak(last, next);
+                continue;
+            }
+            if (last->next.compare_exchange_weak(next, node))
+            {
+                tail.compare_exchange_strong(last, node);
+                break;
+            }
+        }
+        hazards.clear();
+    }
+
+public:
+    ConcurrentSequence()
+    {
+        Node *dummy = new Node;
+        head.store(dummy);
+        tail.store(dummy);
+    }
+
+    // Must not run concurrently with other operations
+    ~ConcurrentSequence()
+    {
+        Node *node = head.load();
+        while (node != nullptr)
+        {
+            Node *next = node->next.load();
+            delete node;
+            node = next;
+        }
+    }
+
+    ConcurrentSequence(const ConcurrentSequence &) = delete;
+    ConcurrentSequence &operator=(const ConcurrentSequence &) = delete;
+
+    /**
+     * @brief adds element to the end of sequence
+     *
+     * @param key key to be inserted
+     * @param info info to be inserted
+     */
+    void push_back(const Key &key, const Info &info)
+    {
+        enqueue(new Node(key, info));
+    }
+    void push_back(Key &&key, Info &&info)
+    {
+        enqueue(new Node(std::move(key), std::move(info)));
+    }
+
+    /**
+     * @brief removes first element in sequence
+     *
+     * @param [out] key key of removed element
+     * @param [out] info info of removed element
+     * @return true if element removed successfully
+     * @return false if sequence was empty
+     */
+    bool pop_front(Key &key, Info &info)
+    {
+        hazard_thread &hazards = hazard_thread::current();
+        while (true)
+        {
+            Node *first = hazards.protect(0, head);
+            Node *last = tail.load();
+            Node *next = first->next.load();
+            hazards.set(1, next);
+            if (first != head.load())
+            {
+                continue;
+            }
+            if (next == nullptr)
+            {
+                hazards.clear();
+                return false; // Sequence is empty
+            }
+            if (first == last)
+            {
+                // Tail is behind, help the other thread to move it
+                tail.compare_exchange_weak(last, next);
+                continue;
+            }
+            if (head.compare_exchange_strong(first, next))
+            {
+                // next is the new dummy, only this thread reads its element
+                key = std::move(next->element->first);
+                info = std::move(next->element->second);
+                next->element.reset();
+                hazards.clear();
+                hazards.retire(first);
+                return true;
+            }
+        }
+    }
+
+    /**
+     * Checks if sequence is empty, the answer may be outdated as soon as it is returned
+     *
+     * @return true if sequence is empty
+     */
+    bool isEmpty() const
+    {
+        hazard_thread &hazards = hazard_thread::current();
+        Node *first = hazards.protect(0, head);
+        bool empty = first->next.load() == nullptr;
+        hazards.clear();
+        return empty;
+    }
+};
+
+#endif
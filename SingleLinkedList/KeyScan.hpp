@@ -0,0 +1,227 @@
+#ifndef KEY_SCAN_HPP
+#define KEY_SCAN_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Scans of contiguous key arrays. Arithmetic keys are compared a whole vector at a time,
+// SSE2 on every x86-64 and AVX2 when compiled for it (-mavx2 or -march=native).
+
+/**
+ * @brief number of keys equal to key, one key at a time
+ */
+template <typename Key>
+unsigned int count_equal_scalar(const Key *keys, unsigned int size, const Key &key)
+{
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < size; i++)
+    {
+        count += keys[i] == key;
+    }
+    return count;
+}
+
+/**
+ * @brief index of the occurrence-th key equal to key, one key at a time
+ *
+ * @param [in,out] occurrence is decreased by the number of equal keys passed, when none is the wanted one
+ * @return unsigned int index of the key, size if it is not in this array
+ */
+template <typename Key>
+unsigned int find_nth_equal_scalar(const Key *keys, unsigned int size, const Key &key, unsigned int &occurrence)
+{
+    for (unsigned int i = 0; i < size; i++)
+    {
+        if (keys[i] == key && --occurrence == 0)
+        {
+            return i;
+        }
+    }
+    return size;
+}
+
+// Keys that are compared by vector instructions
+template <typename Key>
+constexpr bool simd_key = is_arithmetic_v<Key> && !is_same_v<Key, bool> && !is_same_v<Key, long double> &&
+                          (sizeof(Key) == 1 || sizeof(Key) == 2 || sizeof(Key) == 4 || sizeof(Key) == 8);
+
+#ifdef __SSE2__
+// Byte mask of lanes of 16 keys bytes equal to key, every equal key sets sizeof(Key) bits
+template <typename Key>
+inline unsigned int equal_mask_128(const Key *keys, const Key &key)
+{
+    __m128i equal;
+    if constexpr (is_same_v<Key, float>)
+    {
+        equal = _mm_castps_si128(_mm_cmpeq_ps(_mm_loadu_ps(keys), _mm_set1_ps(key)));
+    }
+    else if constexpr (is_same_v<Key, double>)
+    {
+        equal = _mm_castpd_si128(_mm_cmpeq_pd(_mm_loadu_pd(keys), _mm_set1_pd(key)));
+    }
+    else
+    {
+        __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys));
+        if constexpr (sizeof(Key) == 1)
+        {
+            equal = _mm_cmpeq_epi8(data, _mm_set1_epi8(static_cast<char>(key)));
+        }
+        else if constexpr (sizeof(Key) == 2)
+        {
+            equal = _mm_cmpeq_epi16(data, _mm_set1_epi16(static_cast<short>(key)));
+        }
+        else if constexpr (sizeof(Key) == 4)
+        {
+            equal = _mm_cmpeq_epi32(data, _mm_set1_epi32(static_cast<int>(key)));
+        }
+        else
+        {
+            // Both 32-bit halves have to be equal, SSE2 has no 64-bit compare
+            long long wide;
+            memcpy(&wide, &key, sizeof(wide));
+            __m128i halves = _mm_cmpeq_epi32(data, _mm_set1_epi64x(wide));
+            equal = _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+        }
+    }
+    return _mm_movemask_epi8(equal);
+}
+#endif
+
+#ifdef __AVX2__
+template <typename Key>
+inline unsigned int equal_mask_256(const Key *keys, const Key &key)
+{
+    __m256i equal;
+    if constexpr (is_same_v<Key, float>)
+    {
+        equal = _mm256_castps_si256(_mm256_cmp_ps(_mm256_loadu_ps(keys), _mm256_set1_ps(key), _CMP_EQ_OQ));
+    }
+    else if constexpr (is_same_v<Key, double>)
+    {
+        equal = _mm256_castpd_si256(_mm256_cmp_pd(_mm256_loadu_pd(keys), _mm256_set1_pd(key), _CMP_EQ_OQ));
+    }
+    else
+    {
+        __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys));
+        if constexpr (sizeof(Key) == 1)
+        {
+            equal = _mm256_cmpeq_epi8(data, _mm256_set1_epi8(static_cast<char>(key)));
+        }
+        else if constexpr (sizeof(Key) == 2)
+        {
+            equal = _mm256_cmpeq_epi16(data, _mm256_set1_epi16(static_cast<short>(key)));
+        }
+        else if constexpr (sizeof(Key) == 4)
+        {
+            equal = _mm256_cmpeq_epi32(data, _mm256_set1_epi32(static_cast<int>(key)));
+        }
+        else
+        {
+            long long wide;
+            memcpy(&wide, &key, sizeof(wide));
+            equal = _mm256_cmpeq_epi64(data, _mm256_set1_epi64x(wide));
+        }
+    }
+    return static_cast<unsigned int>(_mm256_movemask_epi8(equal));
+}
+#endif
+
+// Calls visit(mask, index of first key) for every full vector of keys, returns number of keys visited
+template <typename Key, typename Visit>
+unsigned int for_each_equal_mask(const Key *keys, unsigned int size, const Key &key, Visit visit)
+{
+    unsigned int i = 0;
+#ifdef __AVX2__
+    constexpr unsigned int wide = 32 / sizeof(Key);
+    for (; i + wide <= size; i += wide)
+    {
+        if (!visit(equal_mask_256(keys + i, key), i))
+        {
+            return i;
+        }
+    }
+#endif
+#ifdef __SSE2__
+    constexpr unsigned int narrow = 16 / sizeof(Key);
+    for (; i + narrow <= size; i += narrow)
+    {
+        if (!visit(equal_mask_128(keys + i, key), i))
+        {
+            return i;
+        }
+    }
+#endif
+    return i;
+}
+
+/**
+ * @brief number of keys equal to key, vectorized for arithmetic keys
+ */
+template <typename Key>
+unsigned int count_equal(const Key *keys, unsigned int size, const Key &key)
+{
+    if constexpr (simd_key<Key>)
+    {
+        unsigned int bits = 0;
+        unsigned int i = for_each_equal_mask(keys, size, key, [&bits](unsigned int mask, unsigned int)
+                                             {
+            bits += __builtin_popcount(mask);
+            return true; });
+        return bits / sizeof(Key) + count_equal_scalar(keys + i, size - i, key);
+    }
+    else
+    {
+        return count_equal_scalar(keys, size, key);
+    }
+}
+
+/**
+ * @brief index of the occurrence-th key equal to key, vectorized for arithmetic keys
+ *
+ * @param [in,out] occurrence is decreased by the number of equal keys passed, when none is the wanted one
+ * @return unsigned int index of the key, size if it is not in this array
+ */
+template <typename Key>
+unsigned int find_nth_equal(const Key *keys, unsigned int size, const Key &key, unsigned int &occurrence)
+{
+    if constexpr (simd_key<Key>)
+    {
+        unsigned int found = size;
+        unsigned int i = for_each_equal_mask(keys, size, key, [&](unsigned int mask, unsigned int first)
+                                             {
+            unsigned int equal = __builtin_popcount(mask) / sizeof(Key);
+            if (equal < occurrence)
+            {
+                occurrence -= equal;
+                return true;
+            }
+            // Drop lowest equal keys until the wanted one is the lowest
+            while (--occurrence > 0)
+            {
+                mask &= ~(((1u << sizeof(Key)) - 1) << __builtin_ctz(mask));
+            }
+            found = first + __builtin_ctz(mask) / sizeof(Key);
+            return false; });
+        if (found != size)
+        {
+            return found;
+        }
+        unsigned int rest = find_nth_equal_scalar(keys + i, size - i, key, occurrence);
+        return rest == size - i ? size : i + rest;
+    }
+    else
+    {
+        return find_nth_equal_scalar(keys, size, key, occurrence);
+    }
+}
+
+#endif
@@ -0,0 +1,380 @@
+#ifndef NODE_POOL_HPP
+#define NODE_POOL_HPP
+
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "../Common/memory_usage.h"
+
+using namespace std;
+
+// Node allocation policies of Sequence. Every policy provides pool<Node> with create, destroy,
+// reserve, adopt (called before nodes of another container are relinked into this one), release and overhead
+
+/**
+ * @brief slots of equal size carved out of growing blocks, with a free list of returned slots
+ *
+ * Pools of containers that exchanged nodes are merged into one group, so memory of a node
+ * lives as long as any container of the group. Merged state forwards to the group's root state.
+ */
+template <size_t Size, size_t Align>
+class node_slots
+{
+private:
+    union Slot
+    {
+        Slot *next;
+        alignas(Align) unsigned char bytes[Size];
+    };
+
+    struct Block
+    {
+        unique_ptr<Slot[]> slots;
+        size_t capacity;
+    };
+
+    vector<Block> blocks;
+    size_t bumpBlock = 0; // block from which new slots are cut
+    size_t bumpUsed = 0;  // slots already cut from the bump block
+    Slot *freeList = nullptr;
+    Slot *freeTail = nullptr;
+    size_t capacity = 0;
+
+    static constexpr size_t firstBlock = 16;
+
+    bool bumpAvailable() const
+    {
+        return bumpBlock < blocks.size() && bumpUsed < blocks[bumpBlock].capacity;
+    }
+
+    void grow(size_t slots)
+    {
+        blocks.push_back(Block{unique_ptr<Slot[]>(new Slot[slots]), slots});
+        capacity += slots;
+        if (!bumpAvailable())
+        {
+            bumpBlock = blocks.size() - 1;
+            bumpUsed = 0;
+        }
+    }
+
+public:
+    shared_ptr<node_slots> forward; // root of the group after this state was merged into another one
+
+    void *allocate(bool reuse)
+    {
+        if (reuse && freeList != nullptr)
+        {
+            Slot *slot = freeList;
+            freeList = slot->next;
+            if (freeList == nullptr)
+            {
+                freeTail = nullptr;
+            }
+            return slot;
+        }
+        while (!bumpAvailable())
+        {
+            if (bumpBlock + 1 < blocks.size())
+            {
+                // Blocks kept by release are cut again
+                bumpBlock++;
+                bumpUsed = 0;
+            }
+            else
+            {
+                grow(std::max(firstBlock, capacity));
+            }
+        }
+        return &blocks[bumpBlock].slots[bumpUsed++];
+    }
+
+    void deallocate(void *pointer)
+    {
+        Slot *slot = static_cast<Slot *>(pointer);
+        slot->next = freeList;
+        freeList = slot;
+        if (freeTail == nullptr)
+        {
+            freeTail = slot;
+        }
+    }
+
+    // Makes sure count slots can be taken without allocating, free slots are not counted
+    void reserve(size_t count)
+    {
+        size_t available = 0;
+        for (size_t block = bumpBlock; block < blocks.size(); block++)
+        {
+            available += blocks[block].capacity - (block == bumpBlock ? bumpUsed : 0);
+        }
+        if (available < count)
+        {
+            grow(count - available);
+        }
+    }
+
+    // Takes over memory and free slots of other, which forwards to this state afterwards
+    void merge(node_slots &other)
+    {
+        if (other.freeList != nullptr)
+        {
+            if (freeList == nullptr)
+            {
+                freeList = other.freeList;
+            }
+            else
+            {
+                freeTail->next = other.freeList;
+            }
+            freeTail = other.freeTail;
+        }
+        if (blocks.empty())
+        {
+            blocks = std::move(other.blocks);
+            bumpBlock = other.bumpBlock;
+            bumpUsed = other.bumpUsed;
+        }
+        else
+        {
+            // Blocks before the bump block hold nodes, blocks after it are unused.
+            // Rest of the other's bump block is given up
+            size_t otherUsed = std::min(other.bumpBlock + 1, other.blocks.size());
+            vector<Block> merged;
+            merged.reserve(blocks.size() + other.blocks.size());
+            std::move(other.blocks.begin(), other.blocks.begin() + otherUsed, back_inserter(merged));
+            std::move(blocks.begin(), blocks.end(), back_inserter(merged));
+            std::move(other.blocks.begin() + otherUsed, other.blocks.end(), back_inserter(merged));
+            blocks = std::move(merged);
+            bumpBlock += otherUsed;
+        }
+        capacity += other.capacity;
+        other.blocks.clear();
+        other.capacity = 0;
+        other.freeList = other.freeTail = nullptr;
+    }
+
+    // Forgets every slot at once, memory is kept for later allocations
+    void release()
+    {
+        bumpBlock = 0;
+        bumpUsed = 0;
+        freeList = freeTail = nullptr;
+    }
+
+    // Memory taken from the heap, with estimated overhead of the heap allocator
+    size_t reservedBytes() const
+    {
+        size_t bytes = 0;
+        for (const Block &block : blocks)
+        {
+            bytes += block.capacity * sizeof(Slot) + allocation_overhead(block.capacity * sizeof(Slot));
+        }
+        return bytes;
+    }
+};
+
+/**
+ * @brief shared part of pooled_nodes and arena_nodes
+ *
+ * @tparam Reuse whether destroyed nodes are handed out again
+ */
+template <typename Node, bool Reuse>
+class slot_pool
+{
+private:
+    using State = node_slots<sizeof(Node), alignof(Node)>;
+
+    shared_ptr<State> state;
+
+    // Returns root state of the group, creating the state on first use
+    State &root()
+    {
+        if (!state)
+        {
+            state = make_shared<State>();
+        }
+        while (state->forward)
+        {
+            state = state->forward;
+        }
+        return *state;
+    }
+
+protected:
+    // Forgets all nodes at once. Memory is kept when no other container shares the pool
+    void releaseAll()
+    {
+        if (!state)
+        {
+            return;
+        }
+        root();
+        if (state.use_count() != 1)
+        {
+            // Other containers may still hold nodes of the group, leave the memory to them
+            state.reset();
+            return;
+        }
+        state->release();
+    }
+
+public:
+    slot_pool() = default;
+    // Copies get their own pool
+    slot_pool(const slot_pool &) {}
+    slot_pool &operator=(const slot_pool &)
+    {
+        return *this;
+    }
+    // Moves hand the whole group over, nodes of the moved container keep their memory
+    slot_pool(slot_pool &&other) noexcept : state(std::move(other.state)) {}
+    slot_pool &operator=(slot_pool &&other) noexcept
+    {
+        state = std::move(other.state);
+        return *this;
+    }
+
+    template <typename... Args>
+    Node *create(Args &&...args)
+    {
+        State &slots = root();
+        void *memory = slots.allocate(Reuse);
+        try
+        {
+            return new (memory) Node(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            if constexpr (Reuse)
+            {
+                slots.deallocate(memory);
+            }
+            throw;
+        }
+    }
+
+    void destroy(Node *node)
+    {
+        node->~Node();
+        if constexpr (Reuse)
+        {
+            root().deallocate(node);
+        }
+    }
+
+    void reserve(size_t count)
+    {
+        root().reserve(count);
+    }
+
+    void adopt(slot_pool &other)
+    {
+        if (!other.state)
+        {
+            return; // other never allocated, it has no nodes
+        }
+        State &mine = root();
+        State &theirs = other.root();
+        if (&mine != &theirs)
+        {
+            mine.merge(theirs);
+            theirs.forward = state;
+        }
+    }
+
+    size_t overhead(size_t nodes) const
+    {
+        if (!state)
+        {
+            return 0;
+        }
+        const State *slots = state.get();
+        while (slots->forward)
+        {
+            slots = slots->forward.get();
+        }
+        size_t used = nodes * sizeof(Node);
+        size_t reserved = slots->reservedBytes();
+        return reserved > used ? reserved - used : 0;
+    }
+};
+
+/**
+ * @brief every node is allocated with new and freed with delete
+ */
+struct heap_nodes
+{
+    template <typename Node>
+    class pool
+    {
+    public:
+        static constexpr bool releases_in_bulk = false;
+
+        template <typename... Args>
+        Node *create(Args &&...args)
+        {
+            return new Node(std::forward<Args>(args)...);
+        }
+        void destroy(Node *node)
+        {
+            delete node;
+        }
+        void reserve(size_t)
+        {
+        }
+        void adopt(pool &)
+        {
+        }
+        void release()
+        {
+        }
+        size_t overhead(size_t nodes) const
+        {
+            return nodes * allocation_overhead(sizeof(Node));
+        }
+    };
+};
+
+/**
+ * @brief nodes come from blocks owned by the container, destroyed nodes go to a free list and are reused
+ * Queue-like use (push_back, pop_front) does not allocate once the pool has grown to the working size
+ */
+struct pooled_nodes
+{
+    template <typename Node>
+    class pool : public slot_pool<Node, true>
+    {
+    public:
+        static constexpr bool releases_in_bulk = false;
+
+        void release()
+        {
+        }
+    };
+};
+
+/**
+ * @brief scratch memory for temporary sequences, nodes are only cut from blocks and never reused one by one
+ * clear() forgets all nodes at once without visiting them when keys and infos are trivially destructible
+ */
+struct arena_nodes
+{
+    template <typename Node>
+    class pool : public slot_pool<Node, false>
+    {
+    public:
+        static constexpr bool releases_in_bulk = true;
+
+        void release()
+        {
+            this->releaseAll();
+        }
+    };
+};
+
+#endif
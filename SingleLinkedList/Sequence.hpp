@@ -2,14 +2,25 @@
 #define SEQUENCE_HPP
 
 #include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <iterator>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "../Common/memory_usage.h"
+#include "../Common/text_export.h"
+#include "../Common/traversal.h"
+#include "NodePool.hpp"
 
 using namespace std;
 
-template <typename Key, typename Info>
+template <typename Key, typename Info, bool KeyIndexed = false, typename NodeAllocation = heap_nodes, bool PositionIndexed = false>
 class Sequence;
 
-template <typename Key, typename Info>
-ostream &operator<<(ostream &os, const Sequence<Key, Info> &sequence)
+template <typename Key, typename Info, bool KeyIndexed, typename NodeAllocation, bool PositionIndexed>
+ostream &operator<<(ostream &os, const Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &sequence)
 {
     os << "[";
     for (auto it = sequence.begin(); it != sequence.empty(); it++)
@@ -25,17 +36,94 @@ ostream &operator<<(ostream &os, const Sequence<Key, Info> &sequence)
     return os;
 };
 
-template <typename Key, typename Info>
-void split_pos(/*const*/ Sequence<Key, Info> &seq, int start_pos, int len1, int len2, int count, Sequence<Key, Info> &seq1, Sequence<Key, Info> &seq2);
+template <typename Key, typename Info, bool KeyIndexed, typename NodeAllocation, bool PositionIndexed>
+void split_pos(/*const*/ Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq, int start_pos, int len1, int len2, int count, Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq1, Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq2);
 
-template <typename Key, typename Info>
-void split_key(Sequence<Key, Info> &seq, const Key &start_key, int start_occ, int len1, int len2, int count, Sequence<Key, Info> &seq1, Sequence<Key, Info> &seq2);
+template <typename Key, typename Info, bool KeyIndexed, typename NodeAllocation, bool PositionIndexed>
+void split_key(Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq, const Key &start_key, int start_occ, int len1, int len2, int count, Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq1, Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq2);
 
-template <typename Key, typename Info>
+// Back link and order label of a node, present only in sequences with key index
+template <typename NodeType, bool Enabled>
+struct key_index_field
+{
+};
+
+template <typename NodeType>
+struct key_index_field<NodeType, true>
+{
+    NodeType *prev = nullptr;
+    // Labels grow along the sequence, they order occurrences of a key without walking the sequence
+    unsigned long long label = 0;
+};
+
+// Stands in for the key index of sequences without one
+struct no_key_index
+{
+};
+
+// Express lanes of a node, present only in sequences with position index
+template <typename NodeType, bool Enabled>
+struct position_field
+{
+};
+
+template <typename NodeType>
+struct position_field<NodeType, true>
+{
+    struct Link
+    {
+        NodeType *next;
+        unsigned int span; // distance to next in elements, meaningless when next is nullptr
+    };
+
+    // Links of levels 1..height, level 0 is the sequence itself
+    Link *lanes = nullptr;
+    unsigned int height = 0;
+
+    position_field() = default;
+    position_field(const position_field &) = delete;
+    ~position_field()
+    {
+        delete[] lanes;
+    }
+};
+
+// Heads of express lanes of a sequence with position index
+template <typename NodeType>
+struct skip_lanes
+{
+    using Link = typename position_field<NodeType, true>::Link;
+
+    static constexpr unsigned int maxLevel = 16;
+
+    Link head[maxLevel + 1] = {}; // levels 1..maxLevel are used
+    unsigned int levels = 0;
+    unsigned int seed = 0x9e3779b9u;
+};
+
+// Stands in for the position index of sequences without one
+struct no_position_index
+{
+};
+
+/**
+ * @brief singly linked sequence of elements with keys that may repeat
+ *
+ * @tparam KeyIndexed if true the sequence keeps a hash index from each key to its nodes in sequence order.
+ * Finding n-th occurrence, counting occurrences and removing elements no longer scan the sequence.
+ * Inserting costs O(log n) amortized to keep order labels of the nodes and O(occurrences of the key)
+ * to keep the index ordered. Key has to be hashable by std::hash
+ * @tparam NodeAllocation where nodes come from: heap_nodes (new and delete), pooled_nodes (per container pool
+ * with free list reuse) or arena_nodes (scratch memory, clear() in O(1) for trivially destructible keys and infos)
+ * @tparam PositionIndexed if true the sequence keeps skip list express lanes with span counts over its nodes.
+ * at(), pop_back() and moving elements by position with append() take O(log n) expected time,
+ * every insertion and removal additionally costs O(log n) expected to keep the lanes
+ */
+template <typename Key, typename Info, bool KeyIndexed, typename NodeAllocation, bool PositionIndexed>
 class Sequence
 {
 private:
-    class Node
+    class Node : public key_index_field<Node, KeyIndexed>, public position_field<Node, PositionIndexed>
     {
     private:
         Node *next;
@@ -44,8 +132,10 @@ private:
         Key key;
         Info info;
 
-        Node(const Key &_key, const Info &_info, Node *_next)
-            : key(_key), info(_info), next(_next) {}
+        // Info is constructed in place from infoArgs
+        template <typename K, typename... InfoArgs>
+        Node(Node *_next, K &&_key, InfoArgs &&...infoArgs)
+            : next(_next), key(std::forward<K>(_key)), info(std::forward<InfoArgs>(infoArgs)...) {}
 
         friend class Sequence;
     };
@@ -54,53 +144,896 @@ private:
     Node *tail;
     unsigned int length;
 
+    conditional_t<KeyIndexed, unordered_map<Key, vector<Node *>>, no_key_index> index;
+    // Labels given to existing nodes to make room for inserted ones
+    conditional_t<KeyIndexed, unsigned long long, no_key_index> relabelled{};
+
+    typename NodeAllocation::template pool<Node> nodePool;
+
+    using Lanes = skip_lanes<Node>;
+    using Link = typename Lanes::Link;
+    static constexpr unsigned int maxLevel = Lanes::maxLevel;
+
+    conditional_t<PositionIndexed, Lanes, no_position_index> skipLanes;
+
+    static constexpr unsigned long long labelStep = 1ull << 32;
+    // Labels are below labelLimit, so sums of two labels do not overflow
+    static constexpr unsigned int labelBits = 63;
+    static constexpr unsigned long long labelLimit = 1ull << labelBits;
+
     // methods
-    Node *getNode(const Key &key, unsigned int occurrence = 1)
+    static bool labelLess(const Node *a, const Node *b)
     {
-        Node *currentNode = head;
-        unsigned int count = 0;
+        return a->label < b->label;
+    };
 
-        while (currentNode != nullptr)
+    // Spreads labels evenly over the whole sequence, order of labels does not change
+    void relabel()
+    {
+        unsigned long long step = labelStep;
+        if (labelLimit / (length + 1) < step)
         {
-            if (currentNode->key == key)
+            step = labelLimit / (length + 1);
+        }
+        unsigned long long label = step;
+        for (Node *node = head; node != nullptr; node = node->next, label += step)
+        {
+            node->label = label;
+        }
+        relabelled += length;
+    };
+
+    /**
+     * Relabels the smallest aligned range of labels around node that is sparse enough, node included
+     * (order maintenance of Bender et al.). A range of 2^i labels is used when it holds fewer than
+     * (2 / 1.3)^i nodes, so ranges that fill up are relabelled rarely and insertions cost O(log n) amortized.
+     */
+    void relabelAround(Node *node)
+    {
+        Node *pivot = node->prev != nullptr ? node->prev : node->next;
+        Node *first = node;
+        Node *last = node;
+        unsigned long long count = 1;
+        double capacity = 1.0;
+        unsigned long long low = 0;
+        for (unsigned int bits = 1; bits <= labelBits; bits++)
+        {
+            capacity *= 2.0 / 1.3;
+            unsigned long long size = 1ull << bits;
+            low = pivot->label & ~(size - 1);
+            unsigned long long high = low + size - 1;
+            while (first->prev != nullptr && first->prev->label >= low && first->prev->label <= high)
+            {
+                first = first->prev;
+                count++;
+            }
+            while (last->next != nullptr && last->next->label >= low && last->next->label <= high)
             {
+                last = last->next;
                 count++;
-                if (count == occurrence)
+            }
+            if (count < capacity || bits == labelBits)
+            {
+                // Spread count nodes evenly over the range
+                unsigned long long step = size / count;
+                unsigned long long label = low;
+                for (Node *current = first; current != last->next; current = current->next, label += step)
                 {
-                    // Found the node with the specified key and occurrence
-                    return currentNode;
+                    current->label = label;
                 }
+                relabelled += count;
+                return;
             }
-            currentNode = currentNode->next;
         }
+    };
 
-        // Node with the specified key and occurrence not found
-        return nullptr;
+    // Gives linked node a label between labels of its neighbours
+    void assignLabel(Node *node)
+    {
+        unsigned long long low = node->prev != nullptr ? node->prev->label : 0;
+        unsigned long long high = node->next != nullptr ? node->next->label : labelLimit;
+        if (high - low < 2)
+        {
+            // No room left between neighbours
+            relabelAround(node);
+        }
+        else if (node->next == nullptr && high - low > labelStep)
+        {
+            // Appending leaves room for further appends
+            node->label = low + labelStep;
+        }
+        else
+        {
+            node->label = low + (high - low) / 2;
+        }
     };
-    Node *getNodeBefore(const Key &key, unsigned int occurrence = 1)
+
+    // Link of a given level of node, of the lane heads when node is nullptr
+    Link *lane(Node *node, unsigned int level) const
     {
-        Node *previousNode = nullptr;
-        Node *currentNode = head;
-        unsigned int count = 0;
+        return node == nullptr ? const_cast<Link *>(&skipLanes.head[level]) : &node->lanes[level - 1];
+    };
 
-        while (currentNode != nullptr)
+    /**
+     * Walks express lanes down to the last tower at every level before given position
+     *
+     * @param position 1-based position, 0 is the place before the first element
+     * @param [out] update last node with a tower at each level with position <= position, nullptr for lane heads
+     * @param [out] rank positions of nodes in update
+     */
+    void lanePath(unsigned int position, Node **update, unsigned int *rank) const
+    {
+        Node *node = nullptr;
+        unsigned int nodePosition = 0;
+        for (unsigned int level = maxLevel; level > 0; level--)
         {
-            if (currentNode->key == key)
+            if (level <= skipLanes.levels)
+            {
+                for (Link *link = lane(node, level); link->next != nullptr && nodePosition + link->span <= position; link = lane(node, level))
+                {
+                    nodePosition += link->span;
+                    node = link->next;
+                }
+            }
+            update[level] = node;
+            rank[level] = nodePosition;
+        }
+    };
+
+    // Returns node at 1-based position, nullptr for position 0
+    Node *nodeAt(unsigned int position) const
+    {
+        Node *node = nullptr;
+        unsigned int nodePosition = 0;
+        if constexpr (PositionIndexed)
+        {
+            Node *update[maxLevel + 1];
+            unsigned int rank[maxLevel + 1];
+            lanePath(position, update, rank);
+            node = update[1];
+            nodePosition = rank[1];
+        }
+        while (nodePosition < position)
+        {
+            node = node == nullptr ? head : node->next;
+            nodePosition++;
+        }
+        return node;
+    };
+
+    // 1-based position of a node, found by comparing order labels along express lanes
+    unsigned int positionOf(Node *target) const
+    {
+        Node *node = nullptr;
+        unsigned int nodePosition = 0;
+        for (unsigned int level = skipLanes.levels; level > 0; level--)
+        {
+            for (Link *link = lane(node, level); link->next != nullptr && link->next->label <= target->label; link = lane(node, level))
+            {
+                nodePosition += link->span;
+                node = link->next;
+            }
+        }
+        while (node != target)
+        {
+            node = node == nullptr ? head : node->next;
+            nodePosition++;
+        }
+        return nodePosition;
+    };
+
+    // Height of a new tower, every level is reached by a quarter of towers of the level below
+    unsigned int randomHeight()
+    {
+        unsigned int height = 0;
+        while (height < maxLevel)
+        {
+            // xorshift keeps lanes independent from the global rand() state
+            skipLanes.seed ^= skipLanes.seed << 13;
+            skipLanes.seed ^= skipLanes.seed >> 17;
+            skipLanes.seed ^= skipLanes.seed << 5;
+            if ((skipLanes.seed & 3) != 0)
+            {
+                break;
+            }
+            height++;
+        }
+        return height;
+    };
+
+    void trimLevels()
+    {
+        while (skipLanes.levels > 0 && skipLanes.head[skipLanes.levels].next == nullptr)
+        {
+            skipLanes.levels--;
+        }
+    };
+
+    // Builds tower of node linked after position beforePosition
+    void lanesInsert(Node *node, unsigned int beforePosition)
+    {
+        Node *update[maxLevel + 1];
+        unsigned int rank[maxLevel + 1];
+        lanePath(beforePosition, update, rank);
+
+        node->height = randomHeight();
+        if (node->height > 0)
+        {
+            node->lanes = new Link[node->height];
+        }
+        skipLanes.levels = std::max(skipLanes.levels, node->height);
+        for (unsigned int level = 1; level <= skipLanes.levels; level++)
+        {
+            Link *link = lane(update[level], level);
+            if (level <= node->height)
+            {
+                node->lanes[level - 1] = {link->next, link->next != nullptr ? link->span - (beforePosition - rank[level]) : 0};
+                *link = {node, beforePosition + 1 - rank[level]};
+            }
+            else if (link->next != nullptr)
+            {
+                link->span++;
+            }
+        }
+    };
+
+    // Removes tower of node at position beforePosition + 1 from lanes
+    void lanesErase(Node *node, unsigned int beforePosition)
+    {
+        Node *update[maxLevel + 1];
+        unsigned int rank[maxLevel + 1];
+        lanePath(beforePosition, update, rank);
+
+        for (unsigned int level = 1; level <= skipLanes.levels; level++)
+        {
+            Link *link = lane(update[level], level);
+            if (link->next == node)
+            {
+                Link &skipped = node->lanes[level - 1];
+                *link = {skipped.next, skipped.next != nullptr ? link->span + skipped.span - 1 : 0};
+            }
+            else if (link->next != nullptr)
+            {
+                link->span--;
+            }
+        }
+        trimLevels();
+    };
+
+    // Removes towers of count elements following position beforePosition from lanes, other towers are kept
+    void lanesEraseRange(unsigned int beforePosition, unsigned int count)
+    {
+        Node *update[maxLevel + 1];
+        unsigned int rank[maxLevel + 1];
+        lanePath(beforePosition, update, rank);
+
+        for (unsigned int level = 1; level <= skipLanes.levels; level++)
+        {
+            Link *link = lane(update[level], level);
+            while (link->next != nullptr && rank[level] + link->span <= beforePosition + count)
+            {
+                Link &skipped = link->next->lanes[level - 1];
+                *link = {skipped.next, skipped.next != nullptr ? link->span + skipped.span : 0};
+            }
+            if (link->next != nullptr)
+            {
+                link->span -= count;
+            }
+        }
+        trimLevels();
+    };
+
+    // Moves lanes of the first count elements out of this sequence
+    Lanes lanesCut(unsigned int count)
+    {
+        Node *update[maxLevel + 1];
+        unsigned int rank[maxLevel + 1];
+        lanePath(count, update, rank);
+
+        Lanes run;
+        run.levels = skipLanes.levels;
+        for (unsigned int level = 1; level <= skipLanes.levels; level++)
+        {
+            Link &first = skipLanes.head[level];
+            if (update[level] == nullptr)
+            {
+                // No tower of this level among moved elements
+                run.head[level] = {nullptr, 0};
+                first.span = first.next != nullptr ? first.span - count : 0;
+            }
+            else
+            {
+                Link *last = lane(update[level], level);
+                run.head[level] = first;
+                first = {last->next, last->next != nullptr ? rank[level] + last->span - count : 0};
+                *last = {nullptr, 0};
+            }
+        }
+        trimLevels();
+        while (run.levels > 0 && run.head[run.levels].next == nullptr)
+        {
+            run.levels--;
+        }
+        return run;
+    };
+
+    // Links lanes of elements appended behind the first count elements
+    void lanesJoin(const Lanes &run, unsigned int count)
+    {
+        Node *update[maxLevel + 1];
+        unsigned int rank[maxLevel + 1];
+        lanePath(count, update, rank);
+
+        for (unsigned int level = 1; level <= run.levels; level++)
+        {
+            if (run.head[level].next != nullptr)
+            {
+                *lane(update[level], level) = {run.head[level].next, count - rank[level] + run.head[level].span};
+            }
+        }
+        skipLanes.levels = std::max(skipLanes.levels, run.levels);
+    };
+
+    // Threads express lanes through the nodes in sequence order. Nodes get new towers when newTowers,
+    // used after the sequence was built without lanes, otherwise towers are reused with their heights
+    void lanesRebuild(bool newTowers = true)
+    {
+        Node *last[maxLevel + 1] = {};
+        unsigned int lastPosition[maxLevel + 1] = {};
+        skipLanes.levels = 0;
+        for (unsigned int level = 1; level <= maxLevel; level++)
+        {
+            skipLanes.head[level] = {nullptr, 0};
+        }
+
+        unsigned int position = 1;
+        for (Node *node = head; node != nullptr; node = node->next, position++)
+        {
+            if (newTowers)
+            {
+                delete[] node->lanes;
+                node->lanes = nullptr;
+                node->height = randomHeight();
+                if (node->height > 0)
+                {
+                    node->lanes = new Link[node->height];
+                }
+            }
+            skipLanes.levels = std::max(skipLanes.levels, node->height);
+            for (unsigned int level = 1; level <= node->height; level++)
+            {
+                *lane(last[level], level) = {node, position - lastPosition[level]};
+                node->lanes[level - 1] = {nullptr, 0};
+                last[level] = node;
+                lastPosition[level] = position;
+            }
+        }
+    };
+
+    // Links node after before, at the front when before is nullptr. beforePosition is 1-based position
+    // of before, it is used only by position index
+    void linkAfter(Node *before, Node *node, unsigned int beforePosition)
+    {
+        Node *after = before == nullptr ? head : before->next;
+        node->next = after;
+        if (before == nullptr)
+        {
+            head = node;
+        }
+        else
+        {
+            before->next = node;
+        }
+        if (before == tail)
+        {
+            tail = node; // Update tail if node is the last one
+        }
+        length++;
+
+        if constexpr (KeyIndexed)
+        {
+            node->prev = before;
+            if (after != nullptr)
+            {
+                after->prev = node;
+            }
+            assignLabel(node);
+            vector<Node *> &nodes = index[node->key];
+            nodes.insert(upper_bound(nodes.begin(), nodes.end(), node, labelLess), node);
+        }
+        if constexpr (PositionIndexed)
+        {
+            lanesInsert(node, beforePosition);
+        }
+    };
+
+    // Unlinks node following before, the first node when before is nullptr
+    Node *unlinkAfter(Node *before, unsigned int beforePosition)
+    {
+        Node *node = before == nullptr ? head : before->next;
+        if constexpr (PositionIndexed)
+        {
+            lanesErase(node, beforePosition);
+        }
+        if (before == nullptr)
+        {
+            head = node->next;
+        }
+        else
+        {
+            before->next = node->next;
+        }
+        if (node == tail)
+        {
+            tail = before; // Update tail if node was the last one
+        }
+        length--;
+
+        if constexpr (KeyIndexed)
+        {
+            if (node->next != nullptr)
+            {
+                node->next->prev = before;
+            }
+            auto found = index.find(node->key);
+            vector<Node *> &nodes = found->second;
+            nodes.erase(lower_bound(nodes.begin(), nodes.end(), node, labelLess));
+            if (nodes.empty())
+            {
+                index.erase(found);
+            }
+        }
+        return node;
+    };
+
+    // Relinks first count nodes of other to the end of this sequence, returns number of moved nodes
+    unsigned int moveFront(Sequence &other, unsigned int count)
+    {
+        if (count > other.length)
+        {
+            count = other.length;
+        }
+        if (count == 0 || &other == this)
+        {
+            return 0;
+        }
+
+        Node *first = other.head;
+        Node *last = other.tail;
+        if (count < other.length)
+        {
+            last = other.nodeAt(count);
+        }
+        if constexpr (PositionIndexed)
+        {
+            lanesJoin(other.lanesCut(count), length);
+        }
+
+        nodePool.adopt(other.nodePool);
+
+        // Detach the run from other
+        other.head = last->next;
+        if (other.head == nullptr)
+        {
+            other.tail = nullptr;
+        }
+        other.length -= count;
+        last->next = nullptr;
+
+        if constexpr (KeyIndexed)
+        {
+            // Moved nodes are the first occurrences of their keys in other
+            unordered_map<Key, unsigned int> moved;
+            for (Node *node = first; node != nullptr; node = node->next)
+            {
+                moved[node->key]++;
+            }
+            if (other.head == nullptr)
+            {
+                other.index.clear();
+            }
+            else
+            {
+                other.head->prev = nullptr;
+                for (const auto &entry : moved)
+                {
+                    auto found = other.index.find(entry.first);
+                    vector<Node *> &nodes = found->second;
+                    nodes.erase(nodes.begin(), nodes.begin() + entry.second);
+                    if (nodes.empty())
+                    {
+                        other.index.erase(found);
+                    }
+                }
+            }
+
+            // Moved nodes follow every node of this sequence, so they go to the ends of index lists
+            bool outOfLabels = false;
+            Node *prev = tail;
+            for (Node *node = first; node != nullptr; prev = node, node = node->next)
+            {
+                node->prev = prev;
+                unsigned long long low = prev != nullptr ? prev->label : 0;
+                outOfLabels = outOfLabels || low >= labelLimit - labelStep;
+                node->label = outOfLabels ? 0 : low + labelStep;
+                index[node->key].push_back(node);
+            }
+        }
+
+        // Attach the run to this sequence
+        if (tail == nullptr)
+        {
+            head = first;
+        }
+        else
+        {
+            tail->next = first;
+        }
+        tail = last;
+        length += count;
+
+        if constexpr (KeyIndexed)
+        {
+            if (tail->label == 0)
+            {
+                // Ran out of labels after the old tail
+                relabel();
+            }
+        }
+        return count;
+    };
+
+    // Copies elements of src into this empty sequence, nodes are linked directly. Pooled and arena nodes are
+    // allocated in one batch, heap_nodes still allocates every node on its own, as each node is deleted alone
+    void copyFrom(const Sequence &src)
+    {
+        nodePool.reserve(src.length);
+        if constexpr (KeyIndexed)
+        {
+            index.reserve(src.index.size());
+        }
+        for (Node *node = src.head; node != nullptr; node = node->next)
+        {
+            Node *copy = nodePool.create(nullptr, node->key, node->info);
+            if (tail == nullptr)
+            {
+                head = copy;
+            }
+            else
+            {
+                tail->next = copy;
+            }
+            if constexpr (KeyIndexed)
+            {
+                // Copies keep the order labels of the source
+                copy->prev = tail;
+                copy->label = node->label;
+                index[copy->key].push_back(copy);
+            }
+            tail = copy;
+            length++;
+        }
+        if constexpr (PositionIndexed)
+        {
+            lanesRebuild();
+        }
+    };
+
+    // Merges two null-terminated runs sorted by less, elements of first go first among equal ones
+    template <typename Less>
+    static Node *mergeRuns(Node *first, Node *second, Less &less)
+    {
+        Node *merged = nullptr;
+        Node **link = &merged;
+        while (first != nullptr && second != nullptr)
+        {
+            if (less(second, first))
+            {
+                *link = second;
+                second = second->next;
+            }
+            else
             {
+                *link = first;
+                first = first->next;
+            }
+            link = &(*link)->next;
+        }
+        *link = first != nullptr ? first : second;
+        return merged;
+    }
+
+    // Stable bottom-up merge sort of a null-terminated list, bins[i] holds a sorted run of 2^i nodes
+    template <typename Less>
+    static Node *sortNodes(Node *list, Less &less)
+    {
+        Node *bins[64] = {};
+        while (list != nullptr)
+        {
+            Node *run = list;
+            list = list->next;
+            run->next = nullptr;
+
+            unsigned int bin = 0;
+            for (; bins[bin] != nullptr; bin++)
+            {
+                // Runs in lower bins hold later elements
+                run = mergeRuns(bins[bin], run, less);
+                bins[bin] = nullptr;
+            }
+            bins[bin] = run;
+        }
+
+        Node *sorted = nullptr;
+        for (Node *run : bins)
+        {
+            if (run != nullptr)
+            {
+                sorted = mergeRuns(run, sorted, less);
+            }
+        }
+        return sorted;
+    }
+
+    // Restores tail, back links, order labels and express lanes after nodes were reordered by relinking
+    void afterRelink()
+    {
+        unsigned long long step = labelStep;
+        if (labelLimit / (length + 1) < step)
+        {
+            step = labelLimit / (length + 1);
+        }
+        if constexpr (KeyIndexed)
+        {
+            for (auto &entry : index)
+            {
+                entry.second.clear();
+            }
+        }
+
+        // One walk spreads the labels like relabel() and fills every key's list in the new order
+        tail = nullptr;
+        unsigned long long label = step;
+        for (Node *node = head; node != nullptr; node = node->next, label += step)
+        {
+            if constexpr (KeyIndexed)
+            {
+                node->prev = tail;
+                node->label = label;
+                index[node->key].push_back(node);
+            }
+            tail = node;
+        }
+        if constexpr (PositionIndexed)
+        {
+            lanesRebuild(false);
+        }
+    };
+
+    // Unlinks every node for which drop(node) holds in one pass, returns them linked in their order
+    template <typename Drop>
+    Node *unlinkWhere(Drop drop, unsigned int &count)
+    {
+        Node *removed = nullptr;
+        Node **removedLink = &removed;
+        Node **link = &head;
+        Node *kept = nullptr;
+        count = 0;
+        for (Node *node = head; node != nullptr; node = node->next)
+        {
+            if (drop(node))
+            {
+                *removedLink = node;
+                removedLink = &node->next;
                 count++;
-                if (count == occurrence)
+            }
+            else
+            {
+                *link = node;
+                link = &node->next;
+                if constexpr (KeyIndexed)
+                {
+                    node->prev = kept;
+                }
+                kept = node;
+            }
+        }
+        *link = nullptr;
+        *removedLink = nullptr;
+        tail = kept;
+        return removed;
+    }
+
+    // Iterators of all elements of key in sequence order, for find_all
+    template <typename iterator>
+    vector<iterator> collectAll(const Key &key) const
+    {
+        vector<iterator> found;
+        if constexpr (KeyIndexed)
+        {
+            auto entry = index.find(key);
+            if (entry != index.end())
+            {
+                found.assign(entry->second.begin(), entry->second.end());
+            }
+            return found;
+        }
+
+        for (Node *node = head; node != nullptr; node = node->next)
+        {
+            if (node->key == key)
+            {
+                found.push_back(iterator(node));
+            }
+        }
+        return found;
+    }
+
+    // Checks through the index that node is linked in this sequence
+    bool indexed(const Node *node) const
+    {
+        auto found = index.find(node->key);
+        if (found == index.end())
+        {
+            return false;
+        }
+        auto at = lower_bound(found->second.begin(), found->second.end(), node, labelLess);
+        return at != found->second.end() && *at == node;
+    };
+
+    // Destroys count nodes already unlinked from the list and from express lanes, drops them from the index.
+    // Nodes of a contiguous range are neighbours in the lists of their keys and are erased from them as blocks
+    void dropUnlinked(Node *removed, unsigned int count, bool contiguous)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        length -= count;
+        if constexpr (KeyIndexed)
+        {
+            if (contiguous)
+            {
+                // First removed node and number of removed nodes of every touched key
+                unordered_map<Key, pair<Node *, unsigned int>> blocks;
+                for (Node *node = removed; node != nullptr; node = node->next)
+                {
+                    pair<Node *, unsigned int> &block = blocks[node->key];
+                    if (block.second++ == 0)
+                    {
+                        block.first = node;
+                    }
+                }
+                for (const auto &block : blocks)
+                {
+                    auto found = index.find(block.first);
+                    vector<Node *> &nodes = found->second;
+                    auto first = lower_bound(nodes.begin(), nodes.end(), block.second.first, labelLess);
+                    nodes.erase(first, first + block.second.second);
+                    if (nodes.empty())
+                    {
+                        index.erase(found);
+                    }
+                }
+            }
+            else
+            {
+                // Removed nodes are marked by a back link to themselves, each touched key is compacted once
+                vector<typename decltype(index)::iterator> touched;
+                for (Node *node = removed; node != nullptr; node = node->next)
+                {
+                    node->prev = node;
+                    touched.push_back(index.find(node->key));
+                }
+                auto byEntry = [](const auto &a, const auto &b)
+                { return std::less<const void *>()(&a->second, &b->second); };
+                std::sort(touched.begin(), touched.end(), byEntry);
+                touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+                for (auto found : touched)
                 {
-                    // Found the node with the specified key and occurrence
-                    // Return the node before this node (previousNode)
-                    return previousNode;
+                    vector<Node *> &nodes = found->second;
+                    nodes.erase(std::remove_if(nodes.begin(), nodes.end(), [](const Node *node)
+                                               { return node->prev == node; }),
+                                nodes.end());
+                    if (nodes.empty())
+                    {
+                        index.erase(found);
+                    }
                 }
             }
+        }
+        while (removed != nullptr)
+        {
+            Node *next = removed->next;
+            nodePool.destroy(removed);
+            removed = next;
+        }
+    };
+
+    template <typename Less>
+    void sortBy(Less less)
+    {
+        head = sortNodes(head, less);
+        afterRelink();
+    }
+
+    template <typename Less>
+    void mergeBy(Sequence &other, Less less)
+    {
+        if (&other == this || other.head == nullptr)
+        {
+            return;
+        }
+        nodePool.adopt(other.nodePool);
+        head = mergeRuns(head, other.head, less);
+        length += other.length;
+        if constexpr (KeyIndexed)
+        {
+            // afterRelink() adds the nodes of other to the index
+            index.reserve(index.size() + other.index.size());
+        }
+        other.head = other.tail = nullptr;
+        other.length = 0;
+        other.clear();
+        afterRelink();
+    }
+
+    /**
+     * Looks up element of a given key and occurrence with a single scan, or in the index if there is one
+     *
+     * @param [out] node is the found node
+     * @param [out] before is the node before found one, nullptr if found node is the first one
+     * @param [out] position is 1-based position of the found node, known only after a scan or with position index
+     * @return true if the element was found
+     */
+    bool locate(const Key &key, unsigned int occurrence, Node *&node, Node *&before, unsigned int &position) const
+    {
+        if constexpr (KeyIndexed)
+        {
+            auto found = index.find(key);
+            if (occurrence == 0 || found == index.end() || found->second.size() < occurrence)
+            {
+                return false;
+            }
+            node = found->second[occurrence - 1];
+            before = node->prev;
+            if constexpr (PositionIndexed)
+            {
+                position = positionOf(node);
+            }
+            return true;
+        }
+
+        Node *previousNode = nullptr;
+        unsigned int count = 0;
+        position = 1;
+        for (Node *currentNode = head; currentNode != nullptr; currentNode = currentNode->next, position++)
+        {
+            if (currentNode->key == key && ++count == occurrence)
+            {
+                // Found the node with the specified key and occurrence
+                node = currentNode;
+                before = previousNode;
+                return true;
+            }
             previousNode = currentNode;
-            currentNode = currentNode->next;
         }
 
-        // Node before the specified key and occurrence not found
-        return nullptr;
+        // Node with the specified key and occurrence not found
+        return false;
+    };
+
+    Node *getNode(const Key &key, unsigned int occurrence = 1)
+    {
+        Node *node, *before;
+        unsigned int position;
+        return locate(key, occurrence, node, before, position) ? node : nullptr;
+    };
+    Node *getNodeBefore(const Key &key, unsigned int occurrence = 1)
+    {
+        Node *node, *before;
+        unsigned int position;
+        return locate(key, occurrence, node, before, position) ? before : nullptr;
     };
 
 public:
@@ -109,9 +1042,28 @@ public:
     {
         clear();
     };
-    Sequence(const Sequence &src)
+    Sequence(const Sequence &src) : head(nullptr), tail(nullptr), length(0)
     {
-        *this = src;
+        try
+        {
+            copyFrom(src);
+        }
+        catch (...)
+        {
+            clear();
+            throw;
+        }
+    };
+    Sequence(Sequence &&src) noexcept
+        : head(src.head), tail(src.tail), length(src.length), index(std::move(src.index)), nodePool(std::move(src.nodePool)), skipLanes(src.skipLanes)
+    {
+        src.head = src.tail = nullptr;
+        src.length = 0;
+        src.skipLanes = {};
+        if constexpr (KeyIndexed)
+        {
+            src.index.clear();
+        }
     };
     Sequence &operator=(const Sequence &src)
     {
@@ -119,30 +1071,85 @@ public:
         {
             // Clear the current sequence
             clear();
-            auto it = src.begin();
-            // Copy elements from src to this using iterators
-            for (int i = 0; i < src.getLength(); i++)
+            copyFrom(src);
+        }
+        return *this;
+    };
+    Sequence &operator=(Sequence &&src) noexcept
+    {
+        if (this != &src)
+        {
+            clear();
+            // Nodes of src stay in the pool they were allocated from, so the pool moves with them
+            head = src.head;
+            tail = src.tail;
+            length = src.length;
+            index = std::move(src.index);
+            nodePool = std::move(src.nodePool);
+            skipLanes = src.skipLanes;
+            src.head = src.tail = nullptr;
+            src.length = 0;
+            src.skipLanes = {};
+            if constexpr (KeyIndexed)
             {
-                push_back(it.key(), it.info());
-                it++;
+                src.index.clear();
             }
         }
         return *this;
     };
 
-    class Iterator
+    /**
+     * @brief iterator over elements of the sequence
+     * Checked iterators throw runtime_error when a null iterator is used. Unchecked ones only assert it,
+     * so release builds (NDEBUG) of hot loops carry no checks. Both kinds convert to each other.
+     * Constant iterators, returned by const member functions, give const keys and infos, other ones convert to them
+     */
+    template <bool Checked, bool Constant = false>
+    class BasicIterator
     {
     private:
+        using KeyType = conditional_t<Constant, const Key, Key>;
+        using InfoType = conditional_t<Constant, const Info, Info>;
+
         Node *current;
 
+        friend class Sequence;
+        template <bool, bool>
+        friend class BasicIterator;
+
+        void check() const
+        {
+            if constexpr (Checked)
+            {
+                if (current == nullptr)
+                {
+                    throw std::runtime_error("Iterator is null");
+                }
+            }
+            else
+            {
+                assert(current != nullptr && "Iterator is null");
+            }
+        };
+
     public:
-        Iterator(Node *ptr = nullptr) : current(ptr){};
-        ~Iterator(){};
-        Iterator(const Iterator &src)
+        using iterator_category = forward_iterator_tag;
+        using value_type = pair<Key, Info>;
+        using difference_type = ptrdiff_t;
+        using reference = element_ref<KeyType, InfoType>;
+        using pointer = element_ref<KeyType, InfoType>;
+
+        BasicIterator(Node *ptr = nullptr) : current(ptr){};
+        // Between checked and unchecked kinds, and from modifying to constant ones
+        template <bool OtherChecked, bool OtherConstant,
+                  typename = enable_if_t<(OtherChecked != Checked || OtherConstant != Constant) && (Constant || !OtherConstant)>>
+        BasicIterator(const BasicIterator<OtherChecked, OtherConstant> &src) : current(src.current) {}
+        ~BasicIterator(){};
+        BasicIterator(const BasicIterator &src)
         {
             this->current = src.current;
         };
-        Iterator &operator=(const Iterator &src)
+        BasicIterator &operator=(const BasicIterator &src)
         {
             if (this != &src)
             {
@@ -151,90 +1158,228 @@ public:
             return *this;
         };
 
-        bool operator==(const Iterator &src) const
+        template <bool OtherChecked, bool OtherConstant>
+        bool operator==(const BasicIterator<OtherChecked, OtherConstant> &src) const
         {
             return current == src.current;
-        };
-        bool operator!=(const Iterator &src) const
+        }
+        template <bool OtherChecked, bool OtherConstant>
+        bool operator!=(const BasicIterator<OtherChecked, OtherConstant> &src) const
         {
             return current != src.current;
-        };
+        }
 
-        Iterator &operator++()
+        BasicIterator &operator++()
         {
-            if (current == nullptr)
-            {
-                throw std::runtime_error("Iterator is null");
-            }
-            if (current != nullptr)
+            check();
+            current = current->next;
+            return *this;
+        };
+        BasicIterator operator++(int)
+        {
+            check();
+            BasicIterator temp = *this;
+            current = current->next;
+            return temp;
+        };
+        BasicIterator operator+(int interval)
+        {
+            check();
+            BasicIterator temp = *this;
+            while (interval > 0 && temp.current != nullptr)
             {
-                current = current->next;
+                temp++;
+                interval--;
             }
-            return *this;
+            return temp;
         };
-        Iterator operator++(int)
+
+        reference operator*() const
+        {
+            check();
+            return {current->key, current->info};
+        };
+        pointer operator->() const
+        {
+            return **this;
+        };
+
+        /**
+         *
+         * @return Key& on which iterator is pointing, const for constant iterators
+         */
+        KeyType &key() const
+        {
+            check();
+            return current->key;
+        };
+
+        /**
+         *
+         * @return Info& on which iterator is pointing, const for constant iterators
+         */
+        InfoType &info() const
+        {
+            check();
+            return current->info;
+        };
+    };
+
+    using Iterator = BasicIterator<true>;
+    using unchecked_iterator = BasicIterator<false>;
+    using const_iterator = BasicIterator<true, true>;
+    using const_unchecked_iterator = BasicIterator<false, true>;
+
+    // Elements from begin() up to the null iterator, for range-for and std algorithms
+    template <typename iterator>
+    struct Range
+    {
+        iterator first;
+        iterator last;
+
+        iterator begin() const
+        {
+            return first;
+        }
+        iterator end() const
+        {
+            return last;
+        }
+    };
+
+    /**
+     * @brief all elements as a range of forward iterators. Unlike end(), its end is past the last element
+     *
+     * @return Range usable in range-for, std::for_each, std::count_if, ...
+     */
+    Range<Iterator> elements()
+    {
+        return {Iterator(head), Iterator()};
+    };
+    Range<const_iterator> elements() const
+    {
+        return {const_iterator(head), const_iterator()};
+    };
+
+    /**
+     * @brief all elements as a range of unchecked iterators, for hot loops
+     */
+    Range<unchecked_iterator> unchecked_elements()
+    {
+        return {unchecked_iterator(head), unchecked_iterator()};
+    };
+    Range<const_unchecked_iterator> unchecked_elements() const
+    {
+        return {const_unchecked_iterator(head), const_unchecked_iterator()};
+    };
+
+    /**
+     * @brief calls fn(key, info) for every element in order, nodes are prefetched a few links ahead
+     */
+    template <typename Fn>
+    void for_each(Fn fn)
+    {
+        visit_prefetched(head, static_cast<Node *>(nullptr), [](Node *node)
+                         { return node->next; }, [&fn](Node *node)
+                         { fn(node->key, node->info); });
+    }
+    template <typename Fn>
+    void for_each(Fn fn) const
+    {
+        visit_prefetched(head, static_cast<Node *>(nullptr), [](Node *node)
+                         { return node->next; }, [&fn](const Node *node)
+                         { fn(node->key, node->info); });
+    }
+
+    /**
+     * @brief number of labels given to elements already in the sequence to make room for inserted ones,
+     * O(log n) amortized per insertion. Always 0 without key index
+     */
+    unsigned long long getRelabelCount() const
+    {
+        if constexpr (KeyIndexed)
         {
-            if (current == nullptr)
-            {
-                throw std::runtime_error("Iterator is null");
-            }
-            Iterator temp = *this;
-            if (current != nullptr)
-            {
-                current = current->next;
-            }
-            return temp;
-        };
-        Iterator operator+(int interval)
+            return relabelled;
+        }
+        else
         {
-            if (current == nullptr)
-            {
-                throw std::runtime_error("Iterator is null");
-            }
-            Iterator temp = *this;
-            while (interval > 0 && temp.current != nullptr)
-            {
-                temp++;
-                interval--;
-            }
-            return temp;
-        };
+            return 0;
+        }
+    };
 
-        /**
-         *
-         * @return Key& on which iterator is pointing
-         */
-        Key &key() const
+    /**
+     * @brief Get the Length sequence
+     *
+     * @return int len of sequence
+     */
+    int getLength() const
+    {
+        return length;
+    };
+
+    /**
+     * @brief memory used by the sequence
+     *
+     * @return memory_stats sizes of nodes, estimated allocator overhead and heap memory owned by keys and infos
+     */
+    memory_stats memory_usage() const
+    {
+        memory_stats stats;
+        stats.elements = length;
+        stats.node_bytes = sizeof(*this) + length * sizeof(Node);
+        stats.allocator_overhead = nodePool.overhead(length);
+        for (Node *node = head; node != nullptr; node = node->next)
         {
-            if (current == nullptr)
+            stats.payload_bytes += heap_bytes(node->key) + heap_bytes(node->info);
+            if constexpr (PositionIndexed)
             {
-                throw std::runtime_error("Iterator is null");
+                if (node->height > 0)
+                {
+                    stats.node_bytes += node->height * sizeof(Link);
+                    stats.allocator_overhead += allocation_overhead(node->height * sizeof(Link));
+                }
             }
-            return current->key;
-        };
-
-        /**
-         *
-         * @return Info& on which iterator is pointing
-         */
-        Info &info() const
+        }
+        if constexpr (KeyIndexed)
         {
-            if (current == nullptr)
+            // Buckets, hash nodes and per key vectors of the index
+            stats.node_bytes += index.bucket_count() * sizeof(void *);
+            for (const auto &entry : index)
             {
-                throw std::runtime_error("Iterator is null");
+                size_t entryBytes = sizeof(entry) + sizeof(void *);
+                size_t vectorBytes = entry.second.capacity() * sizeof(Node *);
+                stats.node_bytes += entryBytes + vectorBytes;
+                stats.allocator_overhead += allocation_overhead(entryBytes) + allocation_overhead(vectorBytes);
+                stats.payload_bytes += heap_bytes(entry.first);
             }
-            return current->info;
-        };
+        }
+        return stats;
     };
 
     /**
-     * @brief Get the Length sequence
+     * @brief writes all elements to out, in the same text operator<< prints
      *
-     * @return int len of sequence
+     * @param out exporter, its buffer can be shared by several exports
      */
-    int getLength() const
+    void export_text(text_exporter &out) const
     {
-        return length;
+        out.open();
+        for (Node *node = head; node != nullptr; node = node->next)
+        {
+            out.element(node->key, node->info);
+        }
+        out.close();
+    };
+
+    /**
+     * @brief prepares memory for count more elements, so inserting them does not allocate
+     * Does nothing for heap_nodes
+     *
+     * @param count number of elements to be inserted
+     */
+    void reserve(unsigned int count)
+    {
+        nodePool.reserve(count);
     };
 
     /**
@@ -260,20 +1405,14 @@ public:
      */
     bool insert_after(const Key &key, const Info &info, const Key &target_key, unsigned int occurrence = 1)
     {
-        Node *targetNode = getNode(target_key, occurrence);
-
-        if (targetNode == nullptr)
+        Node *targetNode, *beforeNode;
+        unsigned int targetPosition;
+        if (!locate(target_key, occurrence, targetNode, beforeNode, targetPosition))
         {
             return false; // Target element not found
         }
 
-        Node *newNode = new Node(key, info, targetNode->next);
-        targetNode->next = newNode;
-        if (targetNode == tail)
-        {
-            tail = newNode; // Update tail if targetNode is the last node
-        }
-        length++;
+        linkAfter(targetNode, nodePool.create(nullptr, key, info), targetPosition);
         return true; // Element inserted successfully
     };
 
@@ -290,25 +1429,15 @@ public:
      */
     bool insert_before(const Key &key, const Info &info, const Key &target_key, unsigned int occurrence = 1)
     {
-
-        if (!exists(target_key, occurrence))
-        {
-            return false;
-        }
-        Node *beforeNode = getNodeBefore(target_key, occurrence);
-
-        if (beforeNode == nullptr)
-        {
-            // required element is the first element in the sequence
-            push_front(key, info);
-        }
-        else
+        Node *targetNode, *beforeNode;
+        unsigned int targetPosition;
+        if (!locate(target_key, occurrence, targetNode, beforeNode, targetPosition))
         {
-            Node *newNode = new Node(key, info, beforeNode->next);
-            beforeNode->next = newNode;
-            length++;
+            return false; // Target element not found
         }
 
+        // beforeNode is nullptr if required element is the first element in the sequence
+        linkAfter(beforeNode, nodePool.create(nullptr, key, info), targetPosition - 1);
         return true; // Element inserted successfully
     };
 
@@ -320,13 +1449,11 @@ public:
      */
     void push_front(const Key &key, const Info &info)
     {
-        Node *newNode = new Node(key, info, head);
-        head = newNode;
-        if (tail == nullptr)
-        {
-            tail = newNode;
-        }
-        length++;
+        linkAfter(nullptr, nodePool.create(nullptr, key, info), 0);
+    };
+    void push_front(Key &&key, Info &&info)
+    {
+        linkAfter(nullptr, nodePool.create(nullptr, std::move(key), std::move(info)), 0);
     };
 
     /**
@@ -337,18 +1464,88 @@ public:
      */
     void push_back(const Key &key, const Info &info)
     {
-        Node *newNode = new Node(key, info, nullptr);
-        if (tail == nullptr)
-        {
-            head = newNode;
-            tail = newNode;
-        }
-        else
+        linkAfter(tail, nodePool.create(nullptr, key, info), length);
+    };
+    void push_back(Key &&key, Info &&info)
+    {
+        linkAfter(tail, nodePool.create(nullptr, std::move(key), std::move(info)), length);
+    };
+
+    /**
+     * @brief constructs element at the beginning of sequence, info is constructed in place
+     *
+     * @param key key of the new element
+     * @param infoArgs arguments passed to constructor of Info
+     * @return Info& info of the new element
+     */
+    template <typename K, typename... InfoArgs>
+    Info &emplace_front(K &&key, InfoArgs &&...infoArgs)
+    {
+        Node *node = nodePool.create(nullptr, std::forward<K>(key), std::forward<InfoArgs>(infoArgs)...);
+        linkAfter(nullptr, node, 0);
+        return node->info;
+    }
+
+    /**
+     * @brief constructs element at the end of sequence, info is constructed in place
+     *
+     * @param key key of the new element
+     * @param infoArgs arguments passed to constructor of Info
+     * @return Info& info of the new element
+     */
+    template <typename K, typename... InfoArgs>
+    Info &emplace_back(K &&key, InfoArgs &&...infoArgs)
+    {
+        Node *node = nodePool.create(nullptr, std::forward<K>(key), std::forward<InfoArgs>(infoArgs)...);
+        linkAfter(tail, node, length);
+        return node->info;
+    }
+
+    /**
+     * Constructs a new element after the specified target element of a given key and occurrence.
+     *
+     * @param target_key The key after which the new element should be constructed.
+     * @param occurrence Specifies after which occurrence of `target_key` to construct.
+     * @param key The key of the new element.
+     * @param infoArgs Arguments passed to constructor of Info.
+     * @return true if the element was successfully constructed, false if the target was not found.
+     */
+    template <typename K, typename... InfoArgs>
+    bool emplace_after(const Key &target_key, unsigned int occurrence, K &&key, InfoArgs &&...infoArgs)
+    {
+        Node *targetNode, *beforeNode;
+        unsigned int targetPosition;
+        if (!locate(target_key, occurrence, targetNode, beforeNode, targetPosition))
         {
-            tail->next = newNode;
-            tail = newNode;
+            return false; // Target element not found
         }
-        length++;
+
+        linkAfter(targetNode, nodePool.create(nullptr, std::forward<K>(key), std::forward<InfoArgs>(infoArgs)...), targetPosition);
+        return true;
+    }
+
+    /**
+     * @brief moves all elements of other sequence to the end of this one, without copying them
+     * Takes constant time, with key index it is linear in length of other
+     *
+     * @param other sequence which elements are moved, it is empty afterwards
+     */
+    void append(Sequence &other)
+    {
+        moveFront(other, other.length);
+    };
+
+    /**
+     * @brief moves first count elements of other sequence to the end of this one, without copying them
+     * Takes O(count) time, O(log n) expected with position index and no key index
+     *
+     * @param other sequence which elements are moved
+     * @param count number of moved elements
+     * @return unsigned int number of moved elements, less than count if other was shorter
+     */
+    unsigned int append(Sequence &other, unsigned int count)
+    {
+        return moveFront(other, count);
     };
 
     /**
@@ -360,31 +1557,164 @@ public:
      */
     bool remove(const Key &key, unsigned int occurrence = 1)
     {
-
-        if (!exists(key, occurrence))
+        Node *targetNode, *beforeNode;
+        unsigned int targetPosition;
+        if (!locate(key, occurrence, targetNode, beforeNode, targetPosition))
         {
             return false;
         }
 
-        Node *beforeNode = getNodeBefore(key, occurrence);
+        nodePool.destroy(unlinkAfter(beforeNode, targetPosition - 1));
+        return true; // Element removed successfully
+    };
+
+    /**
+     * @brief removes all elements of a given key in one pass
+     * With key index only the removed elements are visited, O(log n) expected each with position index
+     *
+     * @param key key of removed elements
+     * @return unsigned int number of removed elements
+     */
+    unsigned int remove_all(const Key &key)
+    {
+        if constexpr (KeyIndexed)
+        {
+            auto found = index.find(key);
+            if (found == index.end())
+            {
+                return 0;
+            }
+            vector<Node *> nodes = std::move(found->second);
+            index.erase(found);
+            for (Node *node : nodes)
+            {
+                if constexpr (PositionIndexed)
+                {
+                    lanesErase(node, positionOf(node) - 1);
+                }
+                Node *before = node->prev;
+                (before == nullptr ? head : before->next) = node->next;
+                if (node->next != nullptr)
+                {
+                    node->next->prev = before;
+                }
+                else
+                {
+                    tail = before;
+                }
+            }
+            length -= nodes.size();
+            for (Node *node : nodes)
+            {
+                nodePool.destroy(node);
+            }
+            return nodes.size();
+        }
+        else
+        {
+            return remove_if([&key](const Key &nodeKey, const Info &)
+                             { return nodeKey == key; });
+        }
+    };
+
+    /**
+     * @brief removes all elements for which pred(key, info) is true, in one pass
+     *
+     * @param pred predicate called once for every element, in order
+     * @return unsigned int number of removed elements
+     */
+    template <typename Pred>
+    unsigned int remove_if(Pred pred)
+    {
+        unsigned int count;
+        Node *removed = unlinkWhere([&pred](const Node *node)
+                                    { return pred(node->key, node->info); },
+                                    count);
+        if constexpr (PositionIndexed)
+        {
+            if (count > 0)
+            {
+                // Lanes are threaded again through the towers of kept nodes
+                lanesRebuild(false);
+            }
+        }
+        dropUnlinked(removed, count, false);
+        return count;
+    }
+
+    /**
+     * @brief removes elements from first up to, but not including, last
+     *
+     * @param first iterator pointing on the first removed element
+     * @param last iterator pointing on the element following the removed ones, empty() to remove up to the end
+     * @return unsigned int number of removed elements
+     */
+    unsigned int erase_range(const Iterator &first, const Iterator &last)
+    {
+        if (first == last)
+        {
+            return 0;
+        }
+        if (first.current == nullptr)
+        {
+            throw std::runtime_error("Iterator is null");
+        }
 
-        if (beforeNode == nullptr)
+        Node *before = nullptr;
+        unsigned int beforePosition = 0;
+        if constexpr (KeyIndexed)
         {
-            // required element is the first element in the sequence
-            pop_front();
+            if (!indexed(first.current))
+            {
+                throw std::runtime_error("Iterator does not belong to this sequence");
+            }
+            before = first.current->prev;
+            if constexpr (PositionIndexed)
+            {
+                beforePosition = positionOf(first.current) - 1;
+            }
         }
         else
         {
-            Node *targetNode = beforeNode->next;
-            beforeNode->next = targetNode->next;
-            if (targetNode == tail)
+            for (Node *node = head; node != first.current; node = node->next, beforePosition++)
             {
-                tail = beforeNode; // Update tail if targetNode is the last node
+                if (node == nullptr)
+                {
+                    throw std::runtime_error("Iterator does not belong to this sequence");
+                }
+                before = node;
             }
-            delete targetNode;
-            length--;
         }
-        return true; // Element removed successfully
+
+        // Nothing is changed until last is known to follow first
+        Node *lastRemoved = first.current;
+        unsigned int count = 1;
+        while (lastRemoved->next != last.current)
+        {
+            if (lastRemoved->next == nullptr)
+            {
+                throw std::runtime_error("Range end is not after its start");
+            }
+            lastRemoved = lastRemoved->next;
+            count++;
+        }
+
+        if constexpr (PositionIndexed)
+        {
+            lanesEraseRange(beforePosition, count);
+        }
+        (before == nullptr ? head : before->next) = last.current;
+        if (last.current == nullptr)
+        {
+            tail = before;
+        }
+        else if constexpr (KeyIndexed)
+        {
+            last.current->prev = before;
+        }
+        lastRemoved->next = nullptr;
+        dropUnlinked(first.current, count, true);
+        return count;
     };
 
     /**
@@ -400,17 +1730,7 @@ public:
             return false; // Sequence is empty, cannot pop front
         }
 
-        Node *temp = head;
-        head = head->next;
-
-        if (head == nullptr)
-        {
-            // If the sequence becomes empty after removal
-            tail = nullptr;
-        }
-
-        delete temp;
-        length--;
+        nodePool.destroy(unlinkAfter(nullptr, 0));
         return true; // Successfully popped the first element
     };
 
@@ -427,31 +1747,26 @@ public:
             return false; // Sequence is empty, cannot pop back
         }
 
-        if (head == tail)
+        Node *prevNode = nullptr;
+        if constexpr (KeyIndexed)
         {
-            // Sequence has only one element
-            delete tail;
-            head = nullptr;
-            tail = nullptr;
+            prevNode = tail->prev;
         }
-        else
+        else if constexpr (PositionIndexed)
+        {
+            prevNode = nodeAt(length - 1);
+        }
+        else if (head != tail)
         {
             // Traverse the list to find the second-to-last node
-            Node *prevNode = nullptr;
-            Node *currentNode = head;
-            while (currentNode->next != nullptr)
+            prevNode = head;
+            while (prevNode->next != tail)
             {
-                prevNode = currentNode;
-                currentNode = currentNode->next;
+                prevNode = prevNode->next;
             }
-
-            // Remove the last node (tail)
-            delete tail;
-            tail = prevNode;
-            tail->next = nullptr;
         }
 
-        length--;
+        nodePool.destroy(unlinkAfter(prevNode, length - 1));
         return true; // Successfully popped the last element
     };
 
@@ -461,8 +1776,27 @@ public:
      */
     void clear()
     {
-        while (pop_front())
+        if constexpr (NodeAllocation::template pool<Node>::releases_in_bulk && is_trivially_destructible_v<Key> && is_trivially_destructible_v<Info> && !PositionIndexed)
+        {
+            // Nodes are dropped together with the arena, without visiting them
+            nodePool.release();
+            head = nullptr;
+        }
+        while (head != nullptr)
+        {
+            Node *temp = head;
+            head = head->next;
+            nodePool.destroy(temp);
+        }
+        tail = nullptr;
+        length = 0;
+        if constexpr (KeyIndexed)
+        {
+            index.clear();
+        }
+        if constexpr (PositionIndexed)
         {
+            skipLanes = Lanes();
         }
     };
 
@@ -475,7 +1809,9 @@ public:
      */
     bool exists(const Key &key, unsigned int occurrence = 1) const
     {
-        return occurrencesOf(key) != 0;
+        Node *node, *before;
+        unsigned int position;
+        return locate(key, occurrence, node, before, position);
     };
 
     /**
@@ -486,6 +1822,12 @@ public:
      */
     unsigned int occurrencesOf(const Key &key) const
     {
+        if constexpr (KeyIndexed)
+        {
+            auto found = index.find(key);
+            return found == index.end() ? 0 : found->second.size();
+        }
+
         Node *currentNode = head;
         unsigned int count = 0;
 
@@ -549,31 +1891,128 @@ public:
         return false;
     };
 
+    /**
+     * @brief iterators pointing on all elements of a given key, collected in one traversal
+     * With key index no traversal is needed
+     *
+     * @param key The key to search for.
+     * @return vector of iterators in sequence order, iterator i points on occurrence i + 1
+     */
+    vector<Iterator> find_all(const Key &key)
+    {
+        return collectAll<Iterator>(key);
+    };
+    vector<const_iterator> find_all(const Key &key) const
+    {
+        return collectAll<const_iterator>(key);
+    };
+
+
+    /**
+     * @brief sorts elements by key, stable, only links between nodes change
+     * Takes O(n log n) time and no extra memory
+     *
+     * @param compare strict weak ordering of keys
+     */
+    template <typename Compare = std::less<Key>>
+    void sort(Compare compare = Compare())
+    {
+        sortBy([&compare](const Node *a, const Node *b)
+               { return compare(a->key, b->key); });
+    }
+
+    /**
+     * @brief sorts elements by info, stable, only links between nodes change
+     *
+     * @param compare strict weak ordering of infos
+     */
+    template <typename Compare = std::less<Info>>
+    void sort_by_info(Compare compare = Compare())
+    {
+        sortBy([&compare](const Node *a, const Node *b)
+               { return compare(a->info, b->info); });
+    }
+
+    /**
+     * @brief moves elements of other into this sequence, both sorted by key, keeping the result sorted
+     * Takes linear time, nodes are relinked. Among equal keys elements of this sequence go first
+     *
+     * @param other sorted sequence, empty afterwards
+     * @param compare strict weak ordering of keys both sequences are sorted by
+     */
+    template <typename Compare = std::less<Key>>
+    void merge(Sequence &other, Compare compare = Compare())
+    {
+        mergeBy(other, [&compare](const Node *a, const Node *b)
+                { return compare(a->key, b->key); });
+    }
+
+    /**
+     * @brief merges sequences sorted by info, like merge
+     *
+     * @param other sequence sorted by info, empty afterwards
+     * @param compare strict weak ordering of infos both sequences are sorted by
+     */
+    template <typename Compare = std::less<Info>>
+    void merge_by_info(Sequence &other, Compare compare = Compare())
+    {
+        mergeBy(other, [&compare](const Node *a, const Node *b)
+                { return compare(a->info, b->info); });
+    }
+
+    /**
+     * @brief element at given position
+     * Takes O(log n) expected time with position index, O(position) otherwise
+     *
+     * @param position 0-based position of element
+     * @return Iterator pointing to the element, null iterator if position is out of sequence
+     */
+    Iterator at(unsigned int position)
+    {
+        return position < length ? Iterator(nodeAt(position + 1)) : Iterator();
+    };
+    const_iterator at(unsigned int position) const
+    {
+        return position < length ? const_iterator(nodeAt(position + 1)) : const_iterator();
+    };
+
     /**
      *
      * @return Iterator pointing to the first element
      */
-    Iterator begin() const
+    Iterator begin()
     {
         return Iterator(head);
     };
+    const_iterator begin() const
+    {
+        return const_iterator(head);
+    };
 
     /**
      *
      * @return Iterator pointing to the last element
      */
-    Iterator end() const
+    Iterator end()
     {
         return Iterator(tail);
     };
+    const_iterator end() const
+    {
+        return const_iterator(tail);
+    };
 
     /**
      *
      * @return Iterator pointing null
      */
-    Iterator empty() const
+    Iterator empty()
     {
         return Iterator(nullptr);
     };
+    const_iterator empty() const
+    {
+        return const_iterator(nullptr);
+    };
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,641 @@
+#ifndef UNROLLED_SEQUENCE_HPP
+#define UNROLLED_SEQUENCE_HPP
+
+#include <iostream>
+#include <stdexcept>
+#include "../Common/memory_usage.h"
+#include "KeyScan.hpp"
+
+using namespace std;
+
+template <typename Key, typename Info, unsigned ChunkCapacity>
+class UnrolledSequence;
+
+template <typename Key, typename Info, unsigned ChunkCapacity>
+ostream &operator<<(ostream &os, const UnrolledSequence<Key, Info, ChunkCapacity> &sequence)
+{
+    os << "[";
+    for (auto it = sequence.begin(); it != sequence.empty(); it++)
+    {
+        os << "(" << it.key() << ", " << it.info() << ")";
+        if (it != sequence.end())
+        {
+            os << ", ";
+        }
+    }
+    os << "]";
+
+    return os;
+};
+
+/**
+ * @brief Sequence storing up to ChunkCapacity elements per node (unrolled linked list).
+ * Offers the interface of Sequence with the same element order and occurrence semantics,
+ * scans walk contiguous arrays of keys instead of chasing a pointer per element.
+ *
+ * Keys of a chunk are contiguous and kept apart from infos, for arithmetic keys occurrencesOf and
+ * searches for n-th occurrence compare a whole SIMD vector of keys at a time.
+ *
+ * Key and Info have to be default constructible, free slots of a chunk hold default values.
+ * Unlike Sequence, inserting or removing elements moves their neighbours within a chunk,
+ * so iterators are invalidated by any modification of the sequence.
+ *
+ * @tparam ChunkCapacity number of elements stored in a single chunk
+ */
+template <typename Key, typename Info, unsigned ChunkCapacity = 16>
+class UnrolledSequence
+{
+    static_assert(ChunkCapacity >= 2, "chunk has to hold at least two elements");
+
+private:
+    class Chunk
+    {
+    private:
+        Chunk *next = nullptr;
+        unsigned count = 0;
+
+    public:
+        Key keys[ChunkCapacity];
+        Info infos[ChunkCapacity];
+
+        friend class UnrolledSequence;
+    };
+
+    Chunk *head;
+    Chunk *tail;
+    unsigned int length;
+
+    // Location of an element, chunk before is nullptr for the head chunk
+    struct Position
+    {
+        Chunk *before;
+        Chunk *chunk;
+        unsigned index;
+    };
+
+    // methods
+    bool locate(const Key &key, unsigned int occurrence, Position &position) const
+    {
+        Chunk *before = nullptr;
+
+        if (occurrence == 0)
+        {
+            return false;
+        }
+        for (Chunk *chunk = head; chunk != nullptr; before = chunk, chunk = chunk->next)
+        {
+            unsigned i = find_nth_equal(chunk->keys, chunk->count, key, occurrence);
+            if (i != chunk->count)
+            {
+                position = {before, chunk, i};
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    void insertAt(Chunk *chunk, unsigned index, const Key &key, const Info &info)
+    {
+        if (chunk->count == ChunkCapacity)
+        {
+            // Move upper half of the full chunk to a new chunk right after it
+            Chunk *added = new Chunk();
+            unsigned half = ChunkCapacity / 2;
+            for (unsigned i = half; i < ChunkCapacity; i++)
+            {
+                added->keys[i - half] = std::move(chunk->keys[i]);
+                added->infos[i - half] = std::move(chunk->infos[i]);
+            }
+            added->count = ChunkCapacity - half;
+            chunk->count = half;
+            added->next = chunk->next;
+            chunk->next = added;
+            if (tail == chunk)
+            {
+                tail = added;
+            }
+            if (index > half)
+            {
+                chunk = added;
+                index -= half;
+            }
+        }
+
+        for (unsigned i = chunk->count; i > index; i--)
+        {
+            chunk->keys[i] = std::move(chunk->keys[i - 1]);
+            chunk->infos[i] = std::move(chunk->infos[i - 1]);
+        }
+        chunk->keys[index] = key;
+        chunk->infos[index] = info;
+        chunk->count++;
+        length++;
+    };
+
+    void unlinkChunk(Chunk *before, Chunk *chunk)
+    {
+        if (before == nullptr)
+        {
+            head = chunk->next;
+        }
+        else
+        {
+            before->next = chunk->next;
+        }
+        if (tail == chunk)
+        {
+            tail = before;
+        }
+        delete chunk;
+    };
+
+    void eraseAt(Chunk *before, Chunk *chunk, unsigned index)
+    {
+        for (unsigned i = index + 1; i < chunk->count; i++)
+        {
+            chunk->keys[i - 1] = std::move(chunk->keys[i]);
+            chunk->infos[i - 1] = std::move(chunk->infos[i]);
+        }
+        chunk->count--;
+        // Free slot must not keep resources of the removed element
+        chunk->keys[chunk->count] = Key();
+        chunk->infos[chunk->count] = Info();
+        length--;
+
+        if (chunk->count == 0)
+        {
+            unlinkChunk(before, chunk);
+            return;
+        }
+
+        // Merge sparse neighbours, so chunks do not degrade to one element each
+        Chunk *next = chunk->next;
+        if (next != nullptr && chunk->count + next->count <= ChunkCapacity / 2)
+        {
+            for (unsigned i = 0; i < next->count; i++)
+            {
+                chunk->keys[chunk->count + i] = std::move(next->keys[i]);
+                chunk->infos[chunk->count + i] = std::move(next->infos[i]);
+            }
+            chunk->count += next->count;
+            unlinkChunk(chunk, next);
+        }
+    };
+
+public:
+    UnrolledSequence() : head(nullptr), tail(nullptr), length(0){};
+    ~UnrolledSequence()
+    {
+        clear();
+    };
+    UnrolledSequence(const UnrolledSequence &src) : head(nullptr), tail(nullptr), length(0)
+    {
+        *this = src;
+    };
+    UnrolledSequence &operator=(const UnrolledSequence &src)
+    {
+        if (this != &src)
+        {
+            clear();
+            // Chunks are copied whole
+            for (Chunk *chunk = src.head; chunk != nullptr; chunk = chunk->next)
+            {
+                Chunk *copy = new Chunk(*chunk);
+                copy->next = nullptr;
+                if (tail == nullptr)
+                {
+                    head = copy;
+                }
+                else
+                {
+                    tail->next = copy;
+                }
+                tail = copy;
+            }
+            length = src.length;
+        }
+        return *this;
+    };
+
+    class Iterator
+    {
+    private:
+        Chunk *chunk;
+        unsigned index;
+
+    public:
+        Iterator(Chunk *chunk = nullptr, unsigned index = 0) : chunk(chunk), index(index){};
+
+        bool operator==(const Iterator &src) const
+        {
+            return chunk == src.chunk && index == src.index;
+        };
+        bool operator!=(const Iterator &src) const
+        {
+            return !(*this == src);
+        };
+
+        Iterator &operator++()
+        {
+            if (chunk == nullptr)
+            {
+                throw std::runtime_error("Iterator is null");
+            }
+            if (++index == chunk->count)
+            {
+                chunk = chunk->next;
+                index = 0;
+            }
+            return *this;
+        };
+        Iterator operator++(int)
+        {
+            Iterator temp = *this;
+            ++*this;
+            return temp;
+        };
+        Iterator operator+(int interval)
+        {
+            if (chunk == nullptr)
+            {
+                throw std::runtime_error("Iterator is null");
+            }
+            Iterator temp = *this;
+            // Whole chunks are skipped at once
+            while (interval > 0 && temp.chunk != nullptr)
+            {
+                unsigned left = temp.chunk->count - temp.index;
+                if ((unsigned)interval < left)
+                {
+                    temp.index += interval;
+                    break;
+                }
+                interval -= left;
+                temp.chunk = temp.chunk->next;
+                temp.index = 0;
+            }
+            return temp;
+        };
+
+        /**
+         *
+         * @return Key& on which iterator is pointing
+         */
+        Key &key() const
+        {
+            if (chunk == nullptr)
+            {
+                throw std::runtime_error("Iterator is null");
+            }
+            return chunk->keys[index];
+        };
+
+        /**
+         *
+         * @return Info& on which iterator is pointing
+         */
+        Info &info() const
+        {
+            if (chunk == nullptr)
+            {
+                throw std::runtime_error("Iterator is null");
+            }
+            return chunk->infos[index];
+        };
+    };
+
+    /**
+     * @brief Get the Length sequence
+     *
+     * @return int len of sequence
+     */
+    int getLength() const
+    {
+        return length;
+    };
+
+    /**
+     * Checks if sequence is empty
+     *
+     * @return true if sequence is empty
+     * @return false if sequence is not empty
+     */
+    bool isEmpty() const
+    {
+        return length == 0;
+    };
+
+    /**
+     * @brief memory used by the sequence, free slots of chunks included in node bytes
+     *
+     * @return memory_stats sizes of chunks, estimated allocator overhead and heap memory owned by keys and infos
+     */
+    memory_stats memory_usage() const
+    {
+        memory_stats stats;
+        stats.elements = length;
+        stats.node_bytes = sizeof(*this);
+        for (Chunk *chunk = head; chunk != nullptr; chunk = chunk->next)
+        {
+            stats.node_bytes += sizeof(Chunk);
+            stats.allocator_overhead += allocation_overhead(sizeof(Chunk));
+            for (unsigned i = 0; i < chunk->count; i++)
+            {
+                stats.payload_bytes += heap_bytes(chunk->keys[i]) + heap_bytes(chunk->infos[i]);
+            }
+        }
+        return stats;
+    };
+
+    /**
+     * Inserts a new element with the provided key and info after the specified target element
+     * of a given key and occurrence.
+     *
+     * @param key The key of the new element to insert.
+     * @param info The info of the new element to insert.
+     * @param target_key The key after which the new element should be inserted.
+     * @param occurrence Specifies after which occurrence of `target_key` to insert.
+     * @return true if the element was successfully inserted, false otherwise.
+     */
+    bool insert_after(const Key &key, const Info &info, const Key &target_key, unsigned int occurrence = 1)
+    {
+        Position position;
+        if (!locate(target_key, occurrence, position))
+        {
+            return false; // Target element not found
+        }
+
+        insertAt(position.chunk, position.index + 1, key, info);
+        return true;
+    };
+
+    /**
+     * Inserts a new element with the provided key and info before the specified target element
+     * of a given key and occurrence.
+     *
+     * @param key The key of the new element to insert.
+     * @param info The info of the new element to insert.
+     * @param target_key The key before which the new element should be inserted.
+     * @param occurrence Specifies before which occurrence of `target_key` to insert.
+     * @return true if the element was successfully inserted, false otherwise.
+     */
+    bool insert_before(const Key &key, const Info &info, const Key &target_key, unsigned int occurrence = 1)
+    {
+        Position position;
+        if (!locate(target_key, occurrence, position))
+        {
+            return false; // Target element not found
+        }
+
+        insertAt(position.chunk, position.index, key, info);
+        return true;
+    };
+
+    /**
+     * @brief adds element to the beginning of sequence
+     *
+     * @param key key to be inserted
+     * @param info info to be inserted
+     */
+    void push_front(const Key &key, const Info &info)
+    {
+        if (head == nullptr || head->count == ChunkCapacity)
+        {
+            Chunk *newChunk = new Chunk();
+            newChunk->next = head;
+            head = newChunk;
+            if (tail == nullptr)
+            {
+                tail = newChunk;
+            }
+        }
+        insertAt(head, 0, key, info);
+    };
+
+    /**
+     * @brief adds element to the end of sequence
+     *
+     * @param key key to be inserted
+     * @param info info to be inserted
+     */
+    void push_back(const Key &key, const Info &info)
+    {
+        if (tail == nullptr || tail->count == ChunkCapacity)
+        {
+            Chunk *newChunk = new Chunk();
+            if (tail == nullptr)
+            {
+                head = newChunk;
+            }
+            else
+            {
+                tail->next = newChunk;
+            }
+            tail = newChunk;
+        }
+        tail->keys[tail->count] = key;
+        tail->infos[tail->count] = info;
+        tail->count++;
+        length++;
+    };
+
+    /**
+     * Removes the specified element of a given key and occurrence.
+     *
+     * @param key The key of the element to remove.
+     * @param occurrence Specifies which occurrence of the key to consider. Defaults to 1.
+     * @return true if an element was successfully removed, false otherwise.
+     */
+    bool remove(const Key &key, unsigned int occurrence = 1)
+    {
+        Position position;
+        if (!locate(key, occurrence, position))
+        {
+            return false;
+        }
+
+        eraseAt(position.before, position.chunk, position.index);
+        return true; // Element removed successfully
+    };
+
+    /**
+     * @brief removes first element in sequence
+     *
+     * @return true if element removed successfully
+     * @return false if element is not removed
+     */
+    bool pop_front()
+    {
+        if (isEmpty())
+        {
+            return false; // Sequence is empty, cannot pop front
+        }
+
+        eraseAt(nullptr, head, 0);
+        return true;
+    };
+
+    /**
+     * @brief removes last element in sequence. Only when the last chunk becomes empty
+     * the chunk before it is looked up, which walks chunks instead of elements
+     *
+     * @return true if element removed successfully
+     * @return false if element is not removed
+     */
+    bool pop_back()
+    {
+        if (isEmpty())
+        {
+            return false; // Sequence is empty, cannot pop back
+        }
+
+        tail->count--;
+        tail->keys[tail->count] = Key();
+        tail->infos[tail->count] = Info();
+        length--;
+
+        if (tail->count == 0)
+        {
+            Chunk *before = nullptr;
+            if (head != tail)
+            {
+                before = head;
+                while (before->next != tail)
+                {
+                    before = before->next;
+                }
+            }
+            unlinkChunk(before, tail);
+        }
+        return true;
+    };
+
+    /**
+     * @brief clears the sequence
+     *
+     */
+    void clear()
+    {
+        while (head != nullptr)
+        {
+            Chunk *next = head->next;
+            delete head;
+            head = next;
+        }
+        tail = nullptr;
+        length = 0;
+    };
+
+    /**
+     * Searches for the specified element of a given key and occurrence.
+     *
+     * @param key The key to search for.
+     * @param occurrence Specifies which occurrence of the key to consider. Defaults to 1.
+     * @return true if the specified element is found, false otherwise.
+     */
+    bool exists(const Key &key, unsigned int occurrence = 1) const
+    {
+        Position position;
+        return locate(key, occurrence, position);
+    };
+
+    /**
+     * @brief number of occurrences of key
+     *
+     * @param key is key which occurrences we count
+     * @return unsigned int number of occurrences of key
+     */
+    unsigned int occurrencesOf(const Key &key) const
+    {
+        unsigned int count = 0;
+
+        for (Chunk *chunk = head; chunk != nullptr; chunk = chunk->next)
+        {
+            count += count_equal(chunk->keys, chunk->count, key);
+        }
+
+        return count;
+    };
+
+    /**
+     * Searches for the specified element of a given key and occurrence.
+     *
+     * @param key The key to search for.
+     * @param occurrence Specifies which occurrence of the key to consider. Defaults to 1.
+     * @param [out] it is iterator pointing on found element
+     * @return true if the specified element is found, false otherwise.
+     */
+    bool find(Iterator &it, const Key &key, unsigned int occurrence = 1)
+    {
+        Position position;
+        if (!locate(key, occurrence, position))
+        {
+            return false; // Element not found
+        }
+
+        it = Iterator(position.chunk, position.index);
+        return true;
+    };
+
+    /**
+     * Searches for the specified element before element with given key and occurrence
+     *
+     * @param key The key to search for.
+     * @param occurrence Specifies which occurrence of the key to consider. Defaults to 1.
+     * @param [out] it is iterator pointing on found element
+     * @return true if the specified element is found, false otherwise.
+     */
+    bool findBefore(Iterator &it, const Key &key, unsigned int occurrence = 1)
+    {
+        Position position;
+        if (!locate(key, occurrence, position))
+        {
+            return false; // Element not found
+        }
+
+        if (position.index > 0)
+        {
+            it = Iterator(position.chunk, position.index - 1);
+            return true;
+        }
+        if (position.before != nullptr)
+        {
+            it = Iterator(position.before, position.before->count - 1);
+            return true;
+        }
+        return false; // Element is the first one
+    };
+
+    /**
+     *
+     * @return Iterator pointing to the first element
+     */
+    Iterator begin() const
+    {
+        return Iterator(head, 0);
+    };
+
+    /**
+     *
+     * @return Iterator pointing to the last element
+     */
+    Iterator end() const
+    {
+        if (tail == nullptr)
+        {
+            return Iterator(nullptr);
+        }
+        return Iterator(tail, tail->count - 1);
+    };
+
+    /**
+     *
+     * @return Iterator pointing null
+     */
+    Iterator empty() const
+    {
+        return Iterator(nullptr);
+    };
+};
+#endif
@@ -0,0 +1,77 @@
+// Cost of one step of checked and unchecked iterators. Built with -DNDEBUG (make iterator_benchmark.out),
+// so unchecked iterators run without their asserts, as in release code
+#include "Sequence.hpp"
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+template <typename It>
+long long sumInfos(It first, It last)
+{
+    long long sum = 0;
+    for (; first != last; ++first)
+    {
+        sum += first->info;
+    }
+    return sum;
+}
+
+bool iteratorTimeMeasurement()
+{
+    // Small sequence traversed many times, nodes stay in cache and only the cost of each step is measured
+    const int size = 1000;
+    const int reps = 20000;
+    Sequence<int, int, false, pooled_nodes> sequence;
+    for (int i = 0; i < size; i++)
+    {
+        sequence.push_back(i, i % 100);
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    long long checkedSum = 0;
+    for (int rep = 0; rep < reps; rep++)
+    {
+        auto elements = sequence.elements();
+        checkedSum += sumInfos(elements.begin(), elements.end());
+    }
+    auto checked_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    long long uncheckedSum = 0;
+    for (int rep = 0; rep < reps; rep++)
+    {
+        auto elements = sequence.unchecked_elements();
+        uncheckedSum += sumInfos(elements.begin(), elements.end());
+    }
+    auto unchecked_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    long long visitedSum = 0;
+    for (int rep = 0; rep < reps; rep++)
+    {
+        sequence.for_each([&visitedSum](const int &, const int &info)
+                          { visitedSum += info; });
+    }
+    auto for_each_time = std::chrono::high_resolution_clock::now() - start_time;
+    if (checkedSum != uncheckedSum || checkedSum != visitedSum)
+    {
+        std::cout << "Traversals disagree" << std::endl;
+        return false;
+    }
+
+    double steps = (double)size * reps;
+    std::cout << "Iterating " << size << " elements " << reps << " times, per element: checked iterator "
+              << std::chrono::duration<double, std::nano>(checked_time).count() / steps << "ns, unchecked iterator "
+              << std::chrono::duration<double, std::nano>(unchecked_time).count() / steps << "ns, for_each "
+              << std::chrono::duration<double, std::nano>(for_each_time).count() / steps << "ns" << std::endl;
+    return true;
+}
+
+int main()
+{
+#ifndef NDEBUG
+    std::cout << "Warning: asserts are enabled, unchecked iterators still check" << std::endl;
+#endif
+    return iteratorTimeMeasurement() ? 0 : 1;
+}
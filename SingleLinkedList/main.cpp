@@ -1,9 +1,21 @@
 #include "Sequence.hpp"
 #include "split.hpp"
+#include "UnrolledSequence.hpp"
+#include "ConcurrentSequence.hpp"
+#include "KeyScan.hpp"
+#include "../Common/copy_on_write.h"
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
@@ -533,7 +545,1604 @@ void testSplitKey2()
         << "SplitPos2 function tests passed!" << std::endl;
 }
 
-int main()
+void testMemoryUsage()
+{
+    Sequence<int, std::string> sequence;
+    memory_stats empty = sequence.memory_usage();
+    assert(empty.elements == 0);
+    assert(empty.payload_bytes == 0);
+    assert(empty.total() == sizeof(sequence));
+
+    sequence.push_back(1, "One");
+    sequence.push_back(2, std::string(100, 'x'));
+    memory_stats stats = sequence.memory_usage();
+    assert(stats.elements == 2);
+    assert(stats.node_bytes > empty.node_bytes);
+    assert(stats.allocator_overhead > 0);
+    // Only the long string owns heap memory
+    assert(stats.payload_bytes >= 101);
+    assert(stats.payload_bytes == heap_bytes(std::string(100, 'x')));
+
+    std::cout << "Memory usage tests passed!" << std::endl;
+}
+
+template <typename Seq>
+void assertSameElements(const Sequence<int, int> &expected, const Seq &actual)
+{
+    assert(expected.getLength() == actual.getLength());
+    auto it = expected.begin();
+    auto actualIt = actual.begin();
+    for (int i = 0; i < expected.getLength(); i++)
+    {
+        assert(it.key() == actualIt.key());
+        assert(it.info() == actualIt.info());
+        it++;
+        actualIt++;
+    }
+    assert(actualIt == actual.empty());
+}
+
+void testUnrolledSequence()
+{
+    // Small chunks, so splitting and merging of chunks is exercised
+    UnrolledSequence<int, int, 4> unrolled;
+    Sequence<int, int> reference;
+
+    srand(5);
+    for (int i = 0; i < 3000; i++)
+    {
+        int key = rand() % 10;
+        int operation = rand() % 7;
+        unsigned occurrences = reference.occurrencesOf(key);
+        assert(unrolled.occurrencesOf(key) == occurrences);
+        unsigned occurrence = occurrences == 0 ? 1 : 1 + rand() % occurrences;
+
+        switch (operation)
+        {
+        case 0:
+            reference.push_back(key, i);
+            unrolled.push_back(key, i);
+            break;
+        case 1:
+            reference.push_front(key, i);
+            unrolled.push_front(key, i);
+            break;
+        case 2:
+        {
+            int newKey = rand() % 10;
+            assert(reference.insert_after(newKey, i, key, occurrence) == (occurrences != 0));
+            assert(unrolled.insert_after(newKey, i, key, occurrence) == (occurrences != 0));
+            break;
+        }
+        case 3:
+            if (occurrences != 0)
+            {
+                int newKey = rand() % 10;
+                assert(reference.insert_before(newKey, i, key, occurrence));
+                assert(unrolled.insert_before(newKey, i, key, occurrence));
+            }
+            break;
+        case 4:
+            if (occurrences != 0)
+            {
+                assert(reference.remove(key, occurrence));
+                assert(unrolled.remove(key, occurrence));
+            }
+            break;
+        case 5:
+            assert(reference.pop_front() == unrolled.pop_front());
+            break;
+        case 6:
+            assert(reference.pop_back() == unrolled.pop_back());
+            break;
+        }
+    }
+    assertSameElements(reference, unrolled);
+
+    // Searching
+    UnrolledSequence<int, std::string, 4> sequence;
+    for (int i = 0; i < 10; i++)
+    {
+        sequence.push_back(i % 3, std::to_string(i));
+    }
+    UnrolledSequence<int, std::string, 4>::Iterator it;
+    assert(sequence.find(it, 1, 3) && it.info() == "7");
+    assert(sequence.findBefore(it, 1, 2) && it.key() == 0 && it.info() == "3");
+    assert(!sequence.findBefore(it, 0));
+    assert(!sequence.find(it, 1, 4));
+    assert(!sequence.insert_after(5, "x", 7));
+    assert(sequence.begin() + 9 == sequence.end());
+    assert(sequence.begin() + 10 == sequence.empty());
+    assert(sequence.end().info() == "9");
+
+    // Copies are independent
+    UnrolledSequence<int, std::string, 4> copy = sequence;
+    copy.remove(0);
+    assert(copy.getLength() == 9 && sequence.getLength() == 10);
+    assert(sequence.occurrencesOf(0) == 4 && copy.occurrencesOf(0) == 3);
+
+    ostringstream output;
+    UnrolledSequence<int, std::string> printed;
+    printed.push_back(1, "One");
+    printed.push_back(2, "Two");
+    output << printed;
+    assert(output.str() == "[(1, One), (2, Two)]");
+
+    std::cout << "Unrolled sequence tests passed!" << std::endl;
+}
+
+// Checks that every occurrence found through the index is the element a plain scan finds
+template <typename IndexedSeq>
+void assertIndexConsistent(const Sequence<int, int> &expected, IndexedSeq &indexed, int keys)
+{
+    assertSameElements(expected, indexed);
+    for (int key = 0; key < keys; key++)
+    {
+        unsigned occurrences = expected.occurrencesOf(key);
+        assert(indexed.occurrencesOf(key) == occurrences);
+        assert(!indexed.exists(key, occurrences + 1));
+        auto it = expected.begin();
+        for (unsigned occurrence = 1; occurrence <= occurrences; occurrence++)
+        {
+            while (it.key() != key)
+            {
+                it++;
+            }
+            typename IndexedSeq::Iterator found;
+            assert(indexed.find(found, key, occurrence));
+            assert(found.info() == it.info());
+            it++;
+        }
+    }
+}
+
+// Inserts count elements at the front of seq and as many before its element of key -1
+void insertCrowded(Sequence<int, int, true> &seq, int count)
+{
+    seq.push_back(-1, 0);
+    for (int i = 0; i < count; i++)
+    {
+        seq.push_front(i, i);
+        seq.insert_before(count + i, i, -1);
+    }
+}
+
+void testKeyIndex()
+{
+    Sequence<int, int, true> indexed;
+    Sequence<int, int> reference;
+
+    srand(7);
+    for (int i = 0; i < 3000; i++)
+    {
+        int key = rand() % 10;
+        int operation = rand() % 7;
+        unsigned occurrences = reference.occurrencesOf(key);
+        assert(indexed.occurrencesOf(key) == occurrences);
+        unsigned occurrence = occurrences == 0 ? 1 : 1 + rand() % occurrences;
+
+        switch (operation)
+        {
+        case 0:
+            reference.push_back(key, i);
+            indexed.push_back(key, i);
+            break;
+        case 1:
+            reference.push_front(key, i);
+            indexed.push_front(key, i);
+            break;
+        case 2:
+        {
+            int newKey = rand() % 10;
+            assert(reference.insert_after(newKey, i, key, occurrence) == (occurrences != 0));
+            assert(indexed.insert_after(newKey, i, key, occurrence) == (occurrences != 0));
+            break;
+        }
+        case 3:
+        {
+            int newKey = rand() % 10;
+            assert(reference.insert_before(newKey, i, key, occurrence) == (occurrences != 0));
+            assert(indexed.insert_before(newKey, i, key, occurrence) == (occurrences != 0));
+            break;
+        }
+        case 4:
+            assert(reference.remove(key, occurrence) == (occurrences != 0));
+            assert(indexed.remove(key, occurrence) == (occurrences != 0));
+            break;
+        case 5:
+            assert(reference.pop_front() == indexed.pop_front());
+            break;
+        case 6:
+            assert(reference.pop_back() == indexed.pop_back());
+            break;
+        }
+    }
+    assertIndexConsistent(reference, indexed, 10);
+
+    // Missing occurrences are reported instead of falling back to the first element
+    Sequence<int, int, true> small;
+    small.push_back(1, 10);
+    small.push_back(2, 20);
+    assert(!small.exists(1, 2));
+    assert(!small.remove(2, 2));
+    assert(!small.insert_before(3, 30, 1, 2));
+    assert(small.getLength() == 2);
+
+    // Splitting keeps indexes of all sequences consistent
+    Sequence<int, int> referenceCopy = reference;
+    Sequence<int, int, true> indexedCopy = indexed;
+    Sequence<int, int> seq1, seq2;
+    Sequence<int, int, true> indexed1, indexed2;
+    split_pos(reference, 5, 3, 4, 20, seq1, seq2);
+    split_pos(indexed, 5, 3, 4, 20, indexed1, indexed2);
+    assertIndexConsistent(reference, indexed, 10);
+    assertIndexConsistent(seq1, indexed1, 10);
+    assertIndexConsistent(seq2, indexed2, 10);
+
+    split_key(referenceCopy, 3, 2, 2, 5, 10, seq1, seq2);
+    split_key(indexedCopy, 3, 2, 2, 5, 10, indexed1, indexed2);
+    assertIndexConsistent(referenceCopy, indexedCopy, 10);
+    assertIndexConsistent(seq1, indexed1, 10);
+    assertIndexConsistent(seq2, indexed2, 10);
+
+    // Inserting again and again at one place exhausts the labels between neighbours many times
+    Sequence<int, int, true> crowded;
+    Sequence<int, int> crowdedReference;
+    crowded.push_back(0, -1);
+    crowdedReference.push_back(0, -1);
+    for (int i = 0; i < 5000; i++)
+    {
+        crowded.push_front(1 + i % 9, i);
+        crowdedReference.push_front(1 + i % 9, i);
+        crowded.insert_before(1 + i % 7, i, 0);
+        crowdedReference.insert_before(1 + i % 7, i, 0);
+    }
+    assertIndexConsistent(crowdedReference, crowded, 10);
+
+    // Local relabelling gives O(log n) labels per insertion, relabelling every node would give O(n)
+    double previousPerInsert = 0;
+    for (int count = 5000; count <= 40000; count *= 2)
+    {
+        Sequence<int, int, true> seq;
+        insertCrowded(seq, count);
+        double perInsert = double(seq.getRelabelCount()) / (2 * count);
+        assert(perInsert < 32);
+        assert(previousPerInsert == 0 || perInsert < previousPerInsert + 3);
+        previousPerInsert = perInsert;
+    }
+    assert((Sequence<int, int>().getRelabelCount() == 0));
+
+    std::cout << "Key index tests passed!" << std::endl;
+}
+
+void testAppend()
+{
+    Sequence<int, int> seq1, seq2;
+    for (int i = 0; i < 5; i++)
+    {
+        seq1.push_back(i, i);
+        seq2.push_back(i + 5, i + 5);
+    }
+
+    assert(seq1.append(seq2, 2) == 2);
+    assert(seq1.getLength() == 7 && seq2.getLength() == 3);
+    assert(seq1.end().key() == 6 && seq2.begin().key() == 7);
+
+    // Asking for more elements than there are moves all of them
+    assert(seq1.append(seq2, 10) == 3);
+    assert(seq2.isEmpty() && seq2.begin() == seq2.empty() && seq2.end() == seq2.empty());
+    assert(seq1.getLength() == 10 && seq1.end().key() == 9);
+
+    seq2.append(seq1);
+    assert(seq1.isEmpty() && seq2.getLength() == 10);
+    auto it = seq2.begin();
+    for (int i = 0; i < 10; i++, it++)
+    {
+        assert(it.key() == i);
+    }
+    seq2.push_back(10, 10);
+    assert(seq2.end().key() == 10 && seq2.getLength() == 11);
+
+    // Indexed sequences move their index entries with the nodes
+    Sequence<int, int, true> indexed1, indexed2;
+    Sequence<int, int> reference1, reference2;
+    for (int i = 0; i < 20; i++)
+    {
+        indexed1.push_back(i % 3, i);
+        reference1.push_back(i % 3, i);
+        indexed2.push_back(i % 4, i + 20);
+        reference2.push_back(i % 4, i + 20);
+    }
+    indexed1.append(indexed2, 7);
+    reference1.append(reference2, 7);
+    assertIndexConsistent(reference1, indexed1, 4);
+    assertIndexConsistent(reference2, indexed2, 4);
+    indexed2.append(indexed1);
+    reference2.append(reference1);
+    assertIndexConsistent(reference1, indexed1, 4);
+    assertIndexConsistent(reference2, indexed2, 4);
+    assert(indexed2.insert_before(7, 7, 2, 5) && indexed2.remove(0, 3));
+    assert(reference2.insert_before(7, 7, 2, 5) && reference2.remove(0, 3));
+    assertIndexConsistent(reference2, indexed2, 8);
+
+    std::cout << "Append tests passed!" << std::endl;
+}
+
+// Queue-like use of a pooled sequence, memory of the sequence is checked only if it has no index
+template <typename Seq>
+void checkQueueChurn(bool withIndex)
+{
+    Seq queue;
+    Sequence<int, int> reference;
+    queue.reserve(64);
+    for (int i = 0; i < 64; i++)
+    {
+        queue.push_back(i % 5, i);
+        reference.push_back(i % 5, i);
+    }
+
+    // Pool does not grow once it holds the working set
+    size_t steadyBytes = queue.memory_usage().total();
+    for (int i = 64; i < 10000; i++)
+    {
+        assert(queue.pop_front() && reference.pop_front());
+        queue.push_back(i % 5, i);
+        reference.push_back(i % 5, i);
+        if (i % 7 == 0)
+        {
+            assert(queue.remove(i % 5, 3) && reference.remove(i % 5, 3));
+            assert(queue.insert_after(9, i, (i + 1) % 5, 2) && reference.insert_after(9, i, (i + 1) % 5, 2));
+        }
+    }
+    assertSameElements(reference, queue);
+    assert(withIndex || queue.memory_usage().total() == steadyBytes);
+}
+
+void testNodePools()
+{
+    checkQueueChurn<Sequence<int, int, false, pooled_nodes>>(false);
+    checkQueueChurn<Sequence<int, int, true, pooled_nodes>>(true);
+
+    // Arena memory is reused after clear
+    Sequence<int, int, false, arena_nodes> arena;
+    for (int i = 0; i < 1000; i++)
+    {
+        arena.push_back(i, i);
+    }
+    size_t arenaBytes = arena.memory_usage().total();
+    arena.clear();
+    assert(arena.isEmpty() && arena.begin() == arena.empty());
+    for (int i = 0; i < 1000; i++)
+    {
+        arena.push_front(i, i);
+    }
+    assert(arena.memory_usage().total() == arenaBytes);
+    assert(arena.begin().key() == 999 && arena.end().key() == 0);
+
+    // Payloads with destructors are still destroyed one by one
+    Sequence<int, std::string, false, arena_nodes> strings;
+    strings.push_back(1, std::string(100, 'x'));
+    strings.clear();
+    strings.push_back(2, "Two");
+    assert(strings.getLength() == 1 && strings.begin().info() == "Two");
+
+    // Nodes relinked between pools outlive the sequence they were allocated by
+    Sequence<int, int, false, pooled_nodes> seq1, seq2;
+    Sequence<int, int, false, arena_nodes> arena1, arena2;
+    {
+        Sequence<int, int, false, pooled_nodes> seq;
+        Sequence<int, int, false, arena_nodes> arenaSeq;
+        for (int i = 0; i < 100; i++)
+        {
+            seq.push_back(i, i);
+            arenaSeq.push_back(i, i);
+        }
+        split_pos(seq, 10, 3, 4, 5, seq1, seq2);
+        split_pos(arenaSeq, 10, 3, 4, 5, arena1, arena2);
+        seq1.append(seq);
+        arenaSeq.clear();
+    }
+    assert(seq1.getLength() == 15 + 65 && seq2.getLength() == 20);
+    assert(arena1.getLength() == 15 && arena2.getLength() == 20);
+    seq1.clear();
+    for (int i = 0; i < 100; i++)
+    {
+        seq2.push_back(i, i);
+        arena2.push_back(i, i);
+    }
+    int sum = 0;
+    for (auto it = arena1.begin(); it != arena1.empty(); it++)
+    {
+        sum += it.key();
+    }
+    assert(sum == 10 + 11 + 12 + 17 + 18 + 19 + 24 + 25 + 26 + 31 + 32 + 33 + 38 + 39 + 40);
+    assert(seq2.getLength() == 120 && arena2.getLength() == 120);
+
+    std::cout << "Node pool tests passed!" << std::endl;
+}
+
+// Counts copies made of it
+struct CopyCounter
+{
+    static int copies;
+    int value;
+
+    CopyCounter(int _value = 0) : value(_value) {}
+    CopyCounter(const CopyCounter &src) : value(src.value)
+    {
+        copies++;
+    }
+    CopyCounter(CopyCounter &&src) noexcept : value(src.value) {}
+    CopyCounter &operator=(const CopyCounter &src)
+    {
+        value = src.value;
+        copies++;
+        return *this;
+    }
+};
+int CopyCounter::copies = 0;
+
+void testMoveAndEmplace()
+{
+    Sequence<int, std::string> original;
+    for (int i = 0; i < 5; i++)
+    {
+        original.push_back(i, std::to_string(i));
+    }
+
+    // Moves take the nodes over
+    auto first = original.begin();
+    Sequence<int, std::string> moved = std::move(original);
+    assert(original.isEmpty() && original.begin() == original.empty());
+    assert(moved.getLength() == 5 && moved.begin() == first);
+
+    Sequence<int, std::string> assigned;
+    assigned.push_back(7, "Seven");
+    assigned = std::move(moved);
+    assert(moved.isEmpty() && assigned.getLength() == 5 && assigned.begin() == first);
+    assert(!assigned.exists(7));
+    moved.push_back(8, "Eight");
+    assert(moved.getLength() == 1);
+
+    // Copies are deep
+    Sequence<int, std::string> copy = assigned;
+    copy.begin().info() = "changed";
+    assert(assigned.begin().info() == "0" && copy.end().info() == "4");
+    copy = copy;
+    assert(copy.getLength() == 5);
+
+    Sequence<int, int, true, pooled_nodes> indexed;
+    Sequence<int, int> reference;
+    for (int i = 0; i < 100; i++)
+    {
+        indexed.push_back(i % 7, i);
+        reference.push_back(i % 7, i);
+    }
+    Sequence<int, int, true, pooled_nodes> indexedCopy = indexed;
+    assertIndexConsistent(reference, indexedCopy, 7);
+    Sequence<int, int, true, pooled_nodes> indexedMoved = std::move(indexedCopy);
+    assertIndexConsistent(reference, indexedMoved, 7);
+    assert(indexedCopy.occurrencesOf(3) == 0);
+    indexedCopy = indexedMoved;
+    assertIndexConsistent(reference, indexedCopy, 7);
+
+    // Elements are constructed in place, rvalues are moved
+    CopyCounter::copies = 0;
+    Sequence<int, CopyCounter> counters;
+    counters.emplace_back(1, 10);
+    counters.emplace_front(0, 5);
+    assert(counters.emplace_after(1, 1, 2, 20));
+    assert(!counters.emplace_after(3, 1, 4, 40));
+    counters.push_back(3, CopyCounter(30));
+    counters.push_front(-1, CopyCounter(-5));
+    assert(CopyCounter::copies == 0);
+    assert(counters.emplace_back(4).value == 0);
+    ostringstream keys;
+    for (auto it = counters.begin(); it != counters.empty(); it++)
+    {
+        keys << it.key() << ":" << it.info().value << " ";
+    }
+    assert(keys.str() == "-1:-5 0:5 1:10 2:20 3:30 4:0 ");
+
+    Sequence<int, std::unique_ptr<int>> owners;
+    owners.push_back(1, std::make_unique<int>(1));
+    owners.emplace_back(2, new int(2));
+    assert(*owners.end().info() == 2 && owners.getLength() == 2);
+
+    std::cout << "Move and emplace tests passed!" << std::endl;
+}
+
+// Checks elements of a sequence with position index, every position is sought through express lanes
+template <typename PositionSeq>
+void assertSamePositions(const Sequence<int, int> &expected, const PositionSeq &actual)
+{
+    assertSameElements(expected, actual);
+    unsigned position = 0;
+    for (auto it = expected.begin(); it != expected.empty(); it++, position++)
+    {
+        auto found = actual.at(position);
+        assert(found.key() == it.key() && found.info() == it.info());
+    }
+    assert(actual.at(position) == actual.empty());
+}
+
+template <typename PositionSeq>
+void checkPositionIndex()
+{
+    PositionSeq positioned;
+    Sequence<int, int> reference;
+
+    srand(11);
+    for (int i = 0; i < 3000; i++)
+    {
+        int key = rand() % 10;
+        int operation = rand() % 8;
+        unsigned occurrences = reference.occurrencesOf(key);
+        unsigned occurrence = occurrences == 0 ? 1 : 1 + rand() % occurrences;
+
+        switch (operation)
+        {
+        case 0:
+            reference.push_back(key, i);
+            positioned.push_back(key, i);
+            break;
+        case 1:
+            reference.push_front(key, i);
+            positioned.push_front(key, i);
+            break;
+        case 2:
+            // Target that does not exist
+            assert(!reference.insert_after(key, i, -1) && !positioned.insert_after(key, i, -1));
+            break;
+        case 3:
+        {
+            int newKey = rand() % 10;
+            assert(reference.insert_before(newKey, i, key, occurrence) == (occurrences != 0));
+            assert(positioned.insert_before(newKey, i, key, occurrence) == (occurrences != 0));
+            break;
+        }
+        case 4:
+            assert(reference.remove(key, occurrence) == positioned.remove(key, occurrence));
+            break;
+        case 5:
+            assert(reference.pop_front() == positioned.pop_front());
+            break;
+        case 6:
+            assert(reference.pop_back() == positioned.pop_back());
+            break;
+        case 7:
+        {
+            int newKey = rand() % 10;
+            assert(reference.insert_after(newKey, i, key, occurrence) == (occurrences != 0));
+            assert(positioned.insert_after(newKey, i, key, occurrence) == (occurrences != 0));
+            break;
+        }
+        }
+        if (i % 500 == 0)
+        {
+            assertSamePositions(reference, positioned);
+        }
+    }
+    assertSamePositions(reference, positioned);
+
+    // Moving runs cuts and joins the lanes
+    PositionSeq seq1, seq2;
+    Sequence<int, int> reference1, reference2;
+    split_pos(positioned, 17, 5, 3, 40, seq1, seq2);
+    split_pos(reference, 17, 5, 3, 40, reference1, reference2);
+    assertSamePositions(reference, positioned);
+    assertSamePositions(reference1, seq1);
+    assertSamePositions(reference2, seq2);
+    seq1.append(seq2, 50);
+    reference1.append(reference2, 50);
+    seq2.append(seq1);
+    reference2.append(reference1);
+    assertSamePositions(reference1, seq1);
+    assertSamePositions(reference2, seq2);
+
+    // Copies get lanes of their own, moves take them over
+    PositionSeq copy = seq2;
+    assert(copy.remove(3) == reference2.remove(3));
+    assertSamePositions(reference2, copy);
+    PositionSeq moved = std::move(copy);
+    assertSamePositions(reference2, moved);
+    assert(copy.at(0) == copy.empty());
+    moved.clear();
+    moved.push_back(1, 1);
+    assert(moved.at(0).key() == 1 && moved.at(1) == moved.empty());
+}
+
+void testPositionIndex()
+{
+    Sequence<int, int> plain;
+    plain.push_back(1, 10);
+    plain.push_back(2, 20);
+    assert(plain.at(1).info() == 20 && plain.at(2) == plain.empty());
+
+    checkPositionIndex<Sequence<int, int, false, heap_nodes, true>>();
+    checkPositionIndex<Sequence<int, int, true, pooled_nodes, true>>();
+
+    std::cout << "Position index tests passed!" << std::endl;
+}
+
+void testConcurrentSequence()
+{
+    ConcurrentSequence<int, std::string> fifo;
+    int key;
+    std::string info;
+    assert(fifo.isEmpty() && !fifo.pop_front(key, info));
+    fifo.push_back(1, "One");
+    fifo.push_back(2, std::string("Two"));
+    assert(!fifo.isEmpty());
+    assert(fifo.pop_front(key, info) && key == 1 && info == "One");
+    assert(fifo.pop_front(key, info) && key == 2 && info == "Two");
+    assert(!fifo.pop_front(key, info) && fifo.isEmpty());
+
+    // Every element is taken exactly once, elements of one producer leave in the order they came
+    const int producers = 4;
+    const int consumers = 4;
+    const int perProducer = 20000;
+    ConcurrentSequence<int, int> queue;
+    std::vector<std::vector<int>> taken(consumers * producers);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&queue, p]()
+                             {
+            for (int i = 0; i < perProducer; i++)
+            {
+                queue.push_back(p, i);
+            } });
+    }
+    std::atomic<int> remaining(producers * perProducer);
+    for (int c = 0; c < consumers; c++)
+    {
+        threads.emplace_back([&queue, &taken, &remaining, c]()
+                             {
+            int producer, number;
+            while (remaining.load() > 0)
+            {
+                if (queue.pop_front(producer, number))
+                {
+                    taken[c * producers + producer].push_back(number);
+                    remaining--;
+                }
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    std::vector<int> count(perProducer * producers, 0);
+    for (int c = 0; c < consumers; c++)
+    {
+        for (int p = 0; p < producers; p++)
+        {
+            const std::vector<int> &numbers = taken[c * producers + p];
+            for (size_t i = 0; i < numbers.size(); i++)
+            {
+                assert(i == 0 || numbers[i - 1] < numbers[i]);
+                count[p * perProducer + numbers[i]]++;
+            }
+        }
+    }
+    for (int taken : count)
+    {
+        assert(taken == 1);
+    }
+    assert(queue.isEmpty());
+
+    std::cout << "Concurrent sequence tests passed!" << std::endl;
+}
+
+// Checks sequence against a stable sort of its elements, elements are compared by less
+template <typename Seq, typename Less>
+void assertStablySorted(const Seq &sequence, std::vector<std::pair<int, int>> elements, Less less)
+{
+    std::stable_sort(elements.begin(), elements.end(), less);
+    Sequence<int, int> expected;
+    for (const auto &element : elements)
+    {
+        expected.push_back(element.first, element.second);
+    }
+    assertSameElements(expected, sequence);
+}
+
+template <typename Seq>
+void checkSort()
+{
+    Seq sequence;
+    std::vector<std::pair<int, int>> elements;
+    srand(13);
+    for (int i = 0; i < 1000; i++)
+    {
+        int key = rand() % 50;
+        sequence.push_back(key, i % 7);
+        elements.push_back({key, i % 7});
+    }
+
+    auto byKey = [](const std::pair<int, int> &a, const std::pair<int, int> &b)
+    { return a.first < b.first; };
+    auto byInfo = [](const std::pair<int, int> &a, const std::pair<int, int> &b)
+    { return a.second < b.second; };
+    auto byKeyDescending = [](const std::pair<int, int> &a, const std::pair<int, int> &b)
+    { return a.first > b.first; };
+
+    sequence.sort_by_info();
+    assertStablySorted(sequence, elements, byInfo);
+    std::stable_sort(elements.begin(), elements.end(), byInfo);
+
+    sequence.sort();
+    assertStablySorted(sequence, elements, byKey);
+    std::stable_sort(elements.begin(), elements.end(), byKey);
+
+    sequence.sort(std::greater<int>());
+    assertStablySorted(sequence, elements, byKeyDescending);
+    std::stable_sort(elements.begin(), elements.end(), byKeyDescending);
+
+    // Sorted sequence keeps working
+    sequence.push_back(-1, 0);
+    assert(sequence.end().key() == -1 && sequence.pop_back());
+    assert(sequence.occurrencesOf(49) == std::count_if(elements.begin(), elements.end(), [](const std::pair<int, int> &e)
+                                                        { return e.first == 49; }));
+
+    // Merging two sorted sequences
+    Seq other;
+    std::vector<std::pair<int, int>> otherElements;
+    for (int i = 0; i < 300; i++)
+    {
+        other.push_back(i % 60, 100 + i);
+        otherElements.push_back({i % 60, 100 + i});
+    }
+    other.sort(std::greater<int>());
+    sequence.merge(other, std::greater<int>());
+    assert(other.isEmpty() && other.begin() == other.empty());
+    std::stable_sort(otherElements.begin(), otherElements.end(), byKeyDescending);
+    elements.insert(elements.end(), otherElements.begin(), otherElements.end());
+    assertStablySorted(sequence, elements, byKeyDescending);
+
+    sequence.sort_by_info();
+    Seq small;
+    small.push_back(1000, 3);
+    small.push_back(1001, 1000);
+    sequence.merge_by_info(small);
+    assert(sequence.getLength() == 1302 && sequence.end().key() == 1001);
+}
+
+void testSort()
+{
+    checkSort<Sequence<int, int>>();
+    checkSort<Sequence<int, int, true, pooled_nodes>>();
+    checkSort<Sequence<int, int, false, heap_nodes, true>>();
+
+    Sequence<int, int, true> indexed;
+    Sequence<int, int> reference;
+    for (int i = 0; i < 100; i++)
+    {
+        indexed.push_back(i % 5, 100 - i);
+        reference.push_back(i % 5, 100 - i);
+    }
+    indexed.sort_by_info();
+    reference.sort_by_info();
+    assertIndexConsistent(reference, indexed, 5);
+
+    Sequence<int, int, false, heap_nodes, true> positioned;
+    for (int i = 0; i < 100; i++)
+    {
+        positioned.push_back(i % 5, 100 - i);
+    }
+    positioned.sort_by_info();
+    assertSamePositions(reference, positioned);
+
+    Sequence<int, int> empty;
+    empty.sort();
+    assert(empty.isEmpty());
+
+    std::cout << "Sort and merge tests passed!" << std::endl;
+}
+
+template <typename Key>
+void checkKeyScan()
+{
+    Key keys[40];
+    for (unsigned size = 0; size <= 40; size++)
+    {
+        for (int rep = 0; rep < 20; rep++)
+        {
+            for (unsigned i = 0; i < size; i++)
+            {
+                keys[i] = static_cast<Key>(rand() % 3);
+            }
+            Key key = static_cast<Key>(rand() % 3);
+            unsigned count = count_equal_scalar(keys, size, key);
+            assert(count_equal(keys, size, key) == count);
+            for (unsigned occurrence = 1; occurrence <= count + 1; occurrence++)
+            {
+                unsigned expectedRest = occurrence, rest = occurrence;
+                unsigned expected = find_nth_equal_scalar(keys, size, key, expectedRest);
+                assert(find_nth_equal(keys, size, key, rest) == expected);
+                assert(rest == expectedRest);
+            }
+        }
+    }
+}
+
+void testKeyScan()
+{
+    srand(19);
+    checkKeyScan<char>();
+    checkKeyScan<unsigned short>();
+    checkKeyScan<int>();
+    checkKeyScan<long long>();
+    checkKeyScan<float>();
+    checkKeyScan<double>();
+
+    // Equality of floating point keys is the one of ==
+    double special[4] = {0.0, -0.0, std::numeric_limits<double>::quiet_NaN(), 1.0};
+    assert(count_equal(special, 4, 0.0) == 2);
+    assert(count_equal(special, 4, std::numeric_limits<double>::quiet_NaN()) == 0);
+
+    UnrolledSequence<long long, int> sequence;
+    for (int i = 0; i < 1000; i++)
+    {
+        sequence.push_back(i % 7, i);
+    }
+    UnrolledSequence<long long, int>::Iterator it;
+    assert(sequence.occurrencesOf(3) == 143);
+    assert(sequence.find(it, 3, 143) && it.info() == 997);
+    assert(!sequence.find(it, 3, 144) && !sequence.find(it, 3, 0));
+
+    std::cout << "Key scan tests passed!" << std::endl;
+}
+
+template <typename Seq>
+void checkBulkRemove()
+{
+    Seq sequence;
+    Sequence<int, int> reference;
+    srand(23);
+    for (int i = 0; i < 2000; i++)
+    {
+        int key = rand() % 10;
+        sequence.push_back(key, i);
+        reference.push_back(key, i);
+    }
+
+    // Same result as removing occurrences one by one
+    unsigned occurrences = reference.occurrencesOf(3);
+    while (reference.remove(3))
+    {
+    }
+    assert(sequence.remove_all(3) == occurrences);
+    assert(sequence.remove_all(3) == 0);
+    assertIndexConsistent(reference, sequence, 10);
+    assertSamePositions(reference, sequence);
+
+    auto odd = [](const int &, const int &info)
+    { return info % 2 == 1; };
+    assert(sequence.remove_if(odd) == reference.remove_if(odd));
+    assertIndexConsistent(reference, sequence, 10);
+    assertSamePositions(reference, sequence);
+
+    // Range in the middle, then up to the end
+    Sequence<int, int> expected;
+    int position = 0;
+    for (auto it = reference.begin(); it != reference.empty(); it++, position++)
+    {
+        if (position < 100 || (position >= 250 && position < 400))
+        {
+            expected.push_back(it.key(), it.info());
+        }
+    }
+    assert(sequence.erase_range(sequence.at(100), sequence.at(250)) == 150);
+    unsigned rest = sequence.getLength() - 250;
+    assert(sequence.erase_range(sequence.at(250), sequence.empty()) == rest);
+    assert(sequence.erase_range(sequence.at(10), sequence.at(10)) == 0);
+    assertIndexConsistent(expected, sequence, 10);
+    assertSamePositions(expected, sequence);
+    assert(sequence.end().info() == expected.end().info());
+
+    // Range end before its start leaves the sequence as it was
+    bool thrown = false;
+    try
+    {
+        sequence.erase_range(sequence.at(20), sequence.at(10));
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown && sequence.getLength() == 250);
+
+    // Iterators of another sequence are rejected
+    Seq other;
+    other.push_back(1, 1);
+    thrown = false;
+    try
+    {
+        sequence.erase_range(other.begin(), sequence.empty());
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown && sequence.getLength() == 250 && other.getLength() == 1);
+
+    // Removing everything
+    assert(sequence.erase_range(sequence.begin(), sequence.empty()) == 250);
+    assert(sequence.isEmpty() && sequence.begin() == sequence.empty() && sequence.end() == sequence.empty());
+    sequence.push_back(1, 1);
+    sequence.push_back(1, 2);
+    assert(sequence.remove_all(1) == 2 && sequence.isEmpty());
+    sequence.push_back(2, 3);
+    assert(sequence.getLength() == 1 && sequence.exists(2) && sequence.end().info() == 3);
+}
+
+void testBulkRemove()
+{
+    checkBulkRemove<Sequence<int, int>>();
+    checkBulkRemove<Sequence<int, int, true>>();
+    checkBulkRemove<Sequence<int, int, false, pooled_nodes, true>>();
+    checkBulkRemove<Sequence<int, int, true, arena_nodes, true>>();
+
+    std::cout << "Bulk remove tests passed!" << std::endl;
+}
+
+template <typename Seq>
+void checkFindAll()
+{
+    Seq sequence;
+    Sequence<int, int> reference;
+    for (int i = 0; i < 500; i++)
+    {
+        sequence.push_back(i % 7, i);
+        reference.push_back(i % 7, i);
+    }
+
+    for (int key = 0; key < 7; key++)
+    {
+        auto found = sequence.find_all(key);
+        assert(found.size() == sequence.occurrencesOf(key));
+        for (unsigned occurrence = 1; occurrence <= found.size(); occurrence++)
+        {
+            typename Seq::Iterator it;
+            assert(sequence.find(it, key, occurrence) && it == found[occurrence - 1]);
+        }
+    }
+    assert(sequence.find_all(7).empty());
+
+    // Found elements are modified and used as range bounds without searching again
+    auto found = sequence.find_all(3);
+    for (auto &it : found)
+    {
+        it.info() = -it.info();
+    }
+    assert(sequence.erase_range(found[10], found[20]) == 70);
+    assert(sequence.getLength() == 430 && sequence.occurrencesOf(3) == found.size() - 10);
+    auto after = sequence.find_all(3);
+    assert(after[10].info() == found[20].info() && after[10].info() < 0);
+}
+
+void testFindAll()
+{
+    checkFindAll<Sequence<int, int>>();
+    checkFindAll<Sequence<int, int, true>>();
+    checkFindAll<Sequence<int, int, true, pooled_nodes, true>>();
+
+    std::cout << "Find all tests passed!" << std::endl;
+}
+
+void testStlIterators()
+{
+    Sequence<int, std::string> sequence;
+    for (int i = 0; i < 10; i++)
+    {
+        sequence.push_back(i, std::to_string(i * i));
+    }
+
+    // Unlike end(), the end of elements() is past the last element
+    auto elements = sequence.elements();
+    assert(std::distance(elements.begin(), elements.end()) == 10);
+    assert(std::count_if(elements.begin(), elements.end(), [](const std::pair<int, std::string> &element)
+                         { return element.first % 2 == 0; }) == 5);
+    auto found = std::find_if(elements.begin(), elements.end(), [](auto element)
+                              { return element.info == "49"; });
+    assert(found->key == 7 && found == sequence.at(7));
+    std::for_each(elements.begin(), elements.end(), [](auto element)
+                  { element.info += "!"; });
+    assert(sequence.end().info() == "81!");
+
+    int sum = 0;
+    for (auto element : sequence.elements())
+    {
+        sum += element.key;
+    }
+    assert(sum == 45);
+
+    std::vector<std::pair<int, std::string>> copied(elements.begin(), elements.end());
+    assert(copied.size() == 10 && copied[3].first == 3 && copied[3].second == "9!");
+
+    // Found element is used by the rest of the interface
+    assert(sequence.erase_range(found, sequence.empty()) == 3);
+
+    const Sequence<int, std::string> &constSequence = sequence;
+    int visited = 0;
+    constSequence.for_each([&visited](const int &key, const std::string &)
+                           { visited += key; });
+    assert(visited == 21);
+    sequence.for_each([](int &key, std::string &)
+                      { key *= 2; });
+    assert(sequence.end().key() == 12);
+
+    Sequence<int, int> empty;
+    assert(empty.elements().begin() == empty.elements().end());
+
+    std::cout << "STL iterator tests passed!" << std::endl;
+}
+
+void testUncheckedIterators()
+{
+    Sequence<int, int> sequence;
+    for (int i = 0; i < 100; i++)
+    {
+        sequence.push_back(i % 10, i);
+    }
+
+    // Both kinds visit the same elements and convert to each other
+    int checkedSum = 0, uncheckedSum = 0;
+    for (auto element : sequence.elements())
+    {
+        checkedSum += element.info;
+    }
+    for (auto element : sequence.unchecked_elements())
+    {
+        uncheckedSum += element.info;
+    }
+    assert(checkedSum == 4950 && uncheckedSum == checkedSum);
+
+    Sequence<int, int>::unchecked_iterator fast = sequence.begin();
+    assert(fast.key() == 0 && (fast + 99).info() == 99);
+    assert(fast + 100 == sequence.empty());
+    auto elements = sequence.unchecked_elements();
+    auto found = std::find_if(elements.begin(), elements.end(), [](auto element)
+                              { return element.info == 95; });
+    Sequence<int, int>::Iterator checked = found;
+    assert(checked.key() == 5);
+    assert(sequence.erase_range(found, sequence.empty()) == 5);
+    assert(sequence.end().info() == 94);
+
+    // Only checked iterators report a null iterator with an exception
+    bool thrown = false;
+    try
+    {
+        sequence.empty().key();
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::cout << "Unchecked iterator tests passed!" << std::endl;
+}
+
+void testCopyOnWrite()
+{
+    Sequence<int, int> source;
+    for (int i = 0; i < 25; i++)
+    {
+        source.push_back(i, i);
+    }
+    Sequence<int, int> seq1, seq2;
+    split_pos(source, 2, 2, 3, 4, seq1, seq2);
+
+    // Results of split are shared by readers without copying elements
+    copy_on_write<Sequence<int, int>> shared(std::move(seq1));
+    std::vector<copy_on_write<Sequence<int, int>>> readers(10, shared);
+    assert(shared.shared() && &readers[9].read() == &shared.read());
+    assert(readers[3]->getLength() == 8 && readers[3]->begin().key() == 2);
+
+    // One reader modifies its copy, the others see the original
+    readers[3].write().remove_all(2);
+    readers[3].write().push_back(100, 100);
+    assert(readers[3]->getLength() == 8 && readers[3]->end().key() == 100);
+    assert(shared->getLength() == 8 && shared->begin().key() == 2 && shared->end().key() == 18);
+    assert(readers[3].read().occurrencesOf(2) == 0 && readers[4].read().occurrencesOf(2) == 1);
+
+    // Readers only get const keys and infos, whichever way they iterate
+    static_assert(std::is_const_v<std::remove_reference_t<decltype(shared.read().begin().info())>>);
+    static_assert(std::is_const_v<std::remove_reference_t<decltype(shared->at(0).key())>>);
+    static_assert(std::is_const_v<std::remove_reference_t<decltype(shared->elements().begin()->info)>>);
+    static_assert(std::is_const_v<std::remove_reference_t<decltype(shared->find_all(2)[0].info())>>);
+    Sequence<int, int>::const_iterator found = readers[3].write().begin();
+    assert(found.key() == 3 && found == readers[3]->begin());
+
+    // Split straight into shared sequences, a shared output is cloned before elements are moved into it
+    Sequence<int, int> again;
+    for (int i = 0; i < 25; i++)
+    {
+        again.push_back(i % 10, i);
+    }
+    copy_on_write<Sequence<int, int>> first, second;
+    split_pos(again, 2, 2, 3, 4, first, second);
+    assert(first->getLength() == 8 && first->begin().info() == 2 && first->end().info() == 18);
+    assert(second->getLength() == 12 && again.getLength() == 5);
+    copy_on_write<Sequence<int, int>> firstCopy = first;
+    assert(firstCopy.shared() && &firstCopy.read() == &first.read());
+    split_key(again, 1, 1, 1, 1, 1, first, second);
+    assert(!firstCopy.shared() && firstCopy->getLength() == 8);
+    assert(first->getLength() == 9 && first->end().info() == 1 && second->end().info() == 22 && again.getLength() == 3);
+
+    std::cout << "Copy on write tests passed!" << std::endl;
+}
+
+void testExportText()
+{
+    // Same text as operator<<, including precision of the stream for floating point infos
+    Sequence<std::string, double> sequence;
+    sequence.push_back("pi", 3.14159265);
+    sequence.push_back("big", 1e21);
+    sequence.push_back("small", -0.000125);
+    for (int precision : {6, 3, 12})
+    {
+        std::ostringstream printed, exported;
+        printed.precision(precision);
+        exported.precision(precision);
+        printed << sequence;
+        export_text(exported, sequence);
+        assert(exported.str() == printed.str());
+    }
+
+    // Small buffer, flushed many times, and strings longer than the buffer
+    Sequence<int, std::string> words;
+    for (int i = 0; i < 300; i++)
+    {
+        words.push_back(-i, std::string(i % 7 == 0 ? 300 : i % 5, 'x'));
+    }
+    std::ostringstream printed, exported;
+    printed << words;
+    {
+        text_exporter out(exported, 128);
+        words.export_text(out);
+    }
+    assert(exported.str() == printed.str());
+
+    // Streaming, elements are exported while they are taken from a queue
+    ConcurrentSequence<int, int> queue;
+    Sequence<int, int> expected;
+    for (int i = 0; i < 1000; i++)
+    {
+        queue.push_back(i, i * i);
+        expected.push_back(i, i * i);
+    }
+    std::ostringstream streamed, whole;
+    {
+        text_exporter out(streamed, 256);
+        out.open();
+        int key, info;
+        while (queue.pop_front(key, info))
+        {
+            out.element(key, info);
+            assert(out.buffered() <= 256);
+        }
+        out.close();
+    }
+    whole << expected;
+    assert(streamed.str() == whole.str());
+
+    std::cout << "Export text tests passed!" << std::endl;
+}
+
+template <typename Seq>
+void layoutTimeMeasurement(const char *name)
+{
+    const int size = 1000000;
+    Seq sequence;
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < size; i++)
+    {
+        sequence.push_back(i % 1000, i);
+    }
+    auto push_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    unsigned found = 0;
+    for (int rep = 0; rep < 10; rep++)
+    {
+        found += sequence.occurrencesOf(rep);
+    }
+    auto scan_time = (std::chrono::high_resolution_clock::now() - start_time) / 10;
+    assert(found == 10 * size / 1000);
+
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < 100; i++)
+    {
+        sequence.insert_after(-1, i, 999, 500);
+    }
+    auto insert_time = (std::chrono::high_resolution_clock::now() - start_time) / 100;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < 100; i++)
+    {
+        sequence.pop_back();
+    }
+    auto pop_time = (std::chrono::high_resolution_clock::now() - start_time) / 100;
+
+    std::cout << name << " " << size << " elements: push_back " << push_time / std::chrono::milliseconds(1)
+              << "ms, occurrencesOf " << scan_time / std::chrono::microseconds(1)
+              << "us, insert_after in the middle " << insert_time / std::chrono::microseconds(1)
+              << "us, pop_back " << pop_time / std::chrono::microseconds(1) << "us" << std::endl;
+}
+
+void labelTimeMeasurement()
+{
+    for (int count = 20000; count <= 160000; count *= 2)
+    {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        Sequence<int, int, true> seq;
+        insertCrowded(seq, count);
+        auto time = std::chrono::high_resolution_clock::now() - start_time;
+        std::cout << "Sequence with key index, " << count << " push_front and " << count
+                  << " insert_before one element: " << time / std::chrono::microseconds(1) << "us, "
+                  << double(seq.getRelabelCount()) / (2 * count) << " labels given per insertion" << std::endl;
+    }
+}
+
+void splitTimeMeasurement()
+{
+    const int size = 1000000;
+    Sequence<int, int> seq, seq1, seq2;
+    for (int i = 0; i < size; i++)
+    {
+        seq.push_back(i % 1000, i);
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    split_pos(seq, 1000, 3, 5, size / 10, seq1, seq2);
+    auto split_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert(seq.getLength() + seq1.getLength() + seq2.getLength() == size);
+
+    std::cout << "split_pos of " << size << " elements: " << split_time / std::chrono::microseconds(1) << "us" << std::endl;
+}
+
+template <typename Seq>
+void queueTimeMeasurement(const char *name)
+{
+    const int size = 1000;
+    const int operations = 10000000;
+    Seq queue;
+    for (int i = 0; i < size; i++)
+    {
+        queue.push_back(i, i);
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < operations; i++)
+    {
+        queue.pop_front();
+        queue.push_back(i, i);
+    }
+    auto queue_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    std::cout << name << " queue of " << size << " elements: " << queue_time / operations / std::chrono::nanoseconds(1)
+              << "ns per pop_front and push_back" << std::endl;
+}
+
+template <typename Seq>
+void positionTimeMeasurement(const char *name)
+{
+    const int size = 1000000;
+    Seq sequence;
+    for (int i = 0; i < size; i++)
+    {
+        sequence.push_back(i % 1000, i);
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    long long sum = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        sum += sequence.at(i * (size / 100) + 7).info();
+    }
+    auto at_time = (std::chrono::high_resolution_clock::now() - start_time) / 100;
+    assert(sum == 100LL * 7 + (size / 100) * (99LL * 100 / 2));
+
+    Seq seq1, seq2;
+    start_time = std::chrono::high_resolution_clock::now();
+    split_pos(sequence, size / 2, 1000, 1000, 100, seq1, seq2);
+    auto split_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    std::cout << name << " " << size << " elements: at " << at_time / std::chrono::microseconds(1)
+              << "us, split_pos in the middle " << split_time / std::chrono::microseconds(1) << "us" << std::endl;
+}
+
+// Sequence behind one mutex, the way it is shared between threads without ConcurrentSequence
+class LockedSequence
+{
+private:
+    std::mutex mutex;
+    Sequence<int, int> sequence;
+
+public:
+    void push_back(int key, int info)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sequence.push_back(key, info);
+    }
+    bool pop_front(int &key, int &info)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (sequence.isEmpty())
+        {
+            return false;
+        }
+        key = sequence.begin().key();
+        info = sequence.begin().info();
+        return sequence.pop_front();
+    }
+};
+
+template <typename Queue>
+double queueThroughput(int threadCount)
+{
+    const int operations = 200000;
+    Queue queue;
+    std::vector<std::thread> threads;
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int t = 0; t < threadCount; t++)
+    {
+        // Every thread pushes and pops in turns
+        threads.emplace_back([&queue, t]()
+                             {
+            int key, info;
+            for (int i = 0; i < operations; i++)
+            {
+                queue.push_back(t, i);
+                queue.pop_front(key, info);
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start_time;
+
+    return 2.0 * operations * threadCount / seconds.count() / 1e6;
+}
+
+void concurrentTimeMeasurement()
+{
+    int maxThreads = std::max(2u, std::thread::hardware_concurrency());
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        std::cout << threads << " threads: ConcurrentSequence " << queueThroughput<ConcurrentSequence<int, int>>(threads)
+                  << " Mops/s, Sequence with mutex " << queueThroughput<LockedSequence>(threads) << " Mops/s" << std::endl;
+    }
+}
+
+template <typename Seq>
+void sortTimeMeasurement(const char *name)
+{
+    const int size = 1000000;
+    Seq sequence;
+    srand(17);
+    for (int i = 0; i < size; i++)
+    {
+        sequence.push_back(rand(), i);
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    sequence.sort();
+    auto sort_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    Seq other;
+    for (int i = 0; i < size; i++)
+    {
+        other.push_back(i * 2, i);
+    }
+    start_time = std::chrono::high_resolution_clock::now();
+    sequence.merge(other);
+    auto merge_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    std::cout << name << " of " << size << " elements: sort " << sort_time / std::chrono::milliseconds(1)
+              << "ms, merge with " << size << " more " << merge_time / std::chrono::milliseconds(1) << "ms" << std::endl;
+}
+
+void removeTimeMeasurement()
+{
+    const int size = 200000;
+    Sequence<int, int> oneByOne, bulk;
+    for (int i = 0; i < size; i++)
+    {
+        oneByOne.push_back(i % 100, i);
+        bulk.push_back(i % 100, i);
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    while (oneByOne.remove(99))
+    {
+    }
+    auto remove_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    bulk.remove_all(99);
+    auto remove_all_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert(bulk.getLength() == oneByOne.getLength());
+
+    std::cout << "Removing " << size / 100 << " of " << size << " elements: remove one by one "
+              << remove_time / std::chrono::milliseconds(1) << "ms, remove_all "
+              << remove_all_time / std::chrono::microseconds(1) << "us" << std::endl;
+
+    // Small ranges of a large sequence unlink only their own towers, the key index finds the element before
+    Sequence<int, int, true, heap_nodes, true> positioned;
+    for (int i = 0; i < 1000000; i++)
+    {
+        positioned.push_back(i % 100, i);
+    }
+    srand(29);
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < 1000; i++)
+    {
+        unsigned first = rand() % (positioned.getLength() - 10);
+        positioned.erase_range(positioned.at(first), positioned.at(first + 1 + rand() % 8));
+    }
+    auto range_time = std::chrono::high_resolution_clock::now() - start_time;
+    std::cout << "1000 erase_range of up to 8 elements in 1000000 elements with key and position index: "
+              << range_time / std::chrono::microseconds(1) << "us" << std::endl;
+}
+
+void findAllTimeMeasurement()
+{
+    const int size = 50000;
+    Sequence<int, int> sequence;
+    for (int i = 0; i < size; i++)
+    {
+        sequence.push_back(i % 50, i);
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    long long sum = 0;
+    Sequence<int, int>::Iterator it;
+    for (unsigned occurrence = 1; sequence.find(it, 7, occurrence); occurrence++)
+    {
+        sum += it.info();
+    }
+    auto find_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    long long sumAll = 0;
+    for (const auto &found : sequence.find_all(7))
+    {
+        sumAll += found.info();
+    }
+    auto find_all_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert(sum == sumAll);
+
+    std::cout << "Visiting " << size / 50 << " occurrences in " << size << " elements: find of every occurrence "
+              << find_time / std::chrono::milliseconds(1) << "ms, find_all "
+              << find_all_time / std::chrono::microseconds(1) << "us" << std::endl;
+}
+
+void traversalTimeMeasurement()
+{
+    // Nodes allocated in order and relinked in random order, so neighbours are far apart in memory
+    const int size = 2000000;
+    Sequence<int, int> sequence;
+    srand(29);
+    for (int i = 0; i < size; i++)
+    {
+        sequence.push_back(rand(), i);
+    }
+    sequence.sort();
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    long long sum = 0;
+    for (auto it = sequence.begin(); it != sequence.empty(); it++)
+    {
+        sum += it.info();
+    }
+    auto iterator_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    long long prefetchedSum = 0;
+    sequence.for_each([&prefetchedSum](const int &, const int &info)
+                      { prefetchedSum += info; });
+    auto prefetch_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert(sum == prefetchedSum);
+
+    std::cout << "Traversal of " << size << " scattered nodes: iterator " << iterator_time / std::chrono::milliseconds(1)
+              << "ms, prefetching for_each " << prefetch_time / std::chrono::milliseconds(1) << "ms" << std::endl;
+}
+
+void copyOnWriteTimeMeasurement()
+{
+    const int size = 1000000;
+    Sequence<int, int> sequence;
+    for (int i = 0; i < size; i++)
+    {
+        sequence.push_back(i, i);
+    }
+    copy_on_write<Sequence<int, int>> shared(std::move(sequence));
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    Sequence<int, int> copy = shared.read();
+    auto copy_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    copy_on_write<Sequence<int, int>> sharedCopy = shared;
+    auto share_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    start_time = std::chrono::high_resolution_clock::now();
+    sharedCopy.write().push_back(size, size);
+    auto clone_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert(copy.getLength() == size && sharedCopy->getLength() == size + 1);
+
+    std::cout << "Sequence of " << size << " elements: copy " << copy_time / std::chrono::milliseconds(1)
+              << "ms, copy_on_write copy " << share_time / std::chrono::nanoseconds(1) << "ns, first write "
+              << clone_time / std::chrono::milliseconds(1) << "ms" << std::endl;
+}
+
+void exportTimeMeasurement()
+{
+    const int size = 1000000;
+    Sequence<int, double> sequence;
+    for (int i = 0; i < size; i++)
+    {
+        sequence.push_back(i, i / 8.0);
+    }
+
+    std::ostringstream printed;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    printed << sequence;
+    auto print_time = std::chrono::high_resolution_clock::now() - start_time;
+
+    std::ostringstream exported;
+    start_time = std::chrono::high_resolution_clock::now();
+    export_text(exported, sequence);
+    auto export_time = std::chrono::high_resolution_clock::now() - start_time;
+    assert(exported.str() == printed.str());
+
+    std::cout << "Sequence of " << size << " elements: operator<< " << print_time / std::chrono::milliseconds(1)
+              << "ms, export_text " << export_time / std::chrono::milliseconds(1) << "ms" << std::endl;
+}
+
+template <typename Seq>
+void scanTimeMeasurement(const char *name)
+{
+    const int size = 10000000;
+    Seq sequence;
+    for (int i = 0; i < size; i++)
+    {
+        sequence.push_back(i % 1000, i);
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    unsigned found = 0;
+    for (int rep = 0; rep < 5; rep++)
+    {
+        found += sequence.occurrencesOf(rep);
+    }
+    auto count_time = (std::chrono::high_resolution_clock::now() - start_time) / 5;
+    assert(found == 5 * size / 1000);
+
+    typename Seq::Iterator it;
+    start_time = std::chrono::high_resolution_clock::now();
+    for (int rep = 0; rep < 5; rep++)
+    {
+        // Last occurrence, the whole sequence is searched
+        assert(sequence.find(it, 999 - rep, size / 1000));
+    }
+    auto find_time = (std::chrono::high_resolution_clock::now() - start_time) / 5;
+
+    std::cout << name << " " << size << " elements: occurrencesOf " << count_time / std::chrono::microseconds(1)
+              << "us, find of last occurrence " << find_time / std::chrono::microseconds(1) << "us" << std::endl;
+}
+
+// Runs the tests, the time measurements too when started with --benchmark
+int main(int argc, char *argv[])
 {
 
     testPoppingPushingElements();
@@ -548,6 +2157,47 @@ int main()
     testSplitPos2();
     testSplitKey();
     testSplitKey2();
+    testMemoryUsage();
+    testUnrolledSequence();
+    testKeyIndex();
+    testAppend();
+    testNodePools();
+    testMoveAndEmplace();
+    testPositionIndex();
+    testConcurrentSequence();
+    testSort();
+    testKeyScan();
+    testExportText();
+    testBulkRemove();
+    testFindAll();
+    testStlIterators();
+    testUncheckedIterators();
+    testCopyOnWrite();
     cout
         << "End of tests!" << endl;
+    if (argc < 2 || string(argv[1]) != "--benchmark")
+    {
+        return 0;
+    }
+
+    layoutTimeMeasurement<Sequence<int, int>>("Sequence");
+    layoutTimeMeasurement<UnrolledSequence<int, int>>("UnrolledSequence");
+    layoutTimeMeasurement<Sequence<int, int, true>>("Sequence with key index");
+    splitTimeMeasurement();
+    labelTimeMeasurement();
+    queueTimeMeasurement<Sequence<int, int>>("heap_nodes");
+    queueTimeMeasurement<Sequence<int, int, false, pooled_nodes>>("pooled_nodes");
+    positionTimeMeasurement<Sequence<int, int>>("Sequence");
+    positionTimeMeasurement<Sequence<int, int, false, heap_nodes, true>>("Sequence with position index");
+    sortTimeMeasurement<Sequence<int, int>>("Sequence");
+    sortTimeMeasurement<Sequence<int, int, true, heap_nodes, true>>("Sequence with key and position index");
+    scanTimeMeasurement<Sequence<int, int>>("Sequence");
+    scanTimeMeasurement<UnrolledSequence<int, int>>("UnrolledSequence");
+    scanTimeMeasurement<UnrolledSequence<int, int, 64>>("UnrolledSequence with 64 element chunks");
+    exportTimeMeasurement();
+    removeTimeMeasurement();
+    findAllTimeMeasurement();
+    traversalTimeMeasurement();
+    copyOnWriteTimeMeasurement();
+    concurrentTimeMeasurement();
 }
\ No newline at end of file
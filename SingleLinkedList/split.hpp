@@ -2,94 +2,75 @@
 #define SPLIT_HPP
 
 #include "Sequence.hpp"
-
-template <typename Key, typename Info>
-void split_pos(/*const*/ Sequence<Key, Info> &seq, int start_pos, int len1, int len2, int count, Sequence<Key, Info> &seq1, Sequence<Key, Info> &seq2)
+#include "../Common/copy_on_write.h"
+
+/**
+ * @brief relinks elements of seq, starting from its prefix_length-th element, alternately to seq1 and seq2
+ * Nodes are moved between sequences, keys and infos are neither allocated nor copied
+ */
+template <typename Key, typename Info, bool KeyIndexed, typename NodeAllocation, bool PositionIndexed>
+void split_runs(Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq, int prefix_length, int len1, int len2, int count, Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq1, Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq2)
 {
-    typename Sequence<Key, Info>::Iterator it = seq.begin();
-    Sequence<Key, Info> new_sequence;
-
-    int current_pos = 0;
+    Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> prefix;
+    prefix.append(seq, std::max(prefix_length, 0));
 
-    while (current_pos < start_pos && it != seq.end())
+    for (int c = 0; c < count && !seq.isEmpty(); c++)
     {
-        new_sequence.push_back(it.key(), it.info());
-        ++it;
-        ++current_pos;
+        seq1.append(seq, std::max(len1, 0));
+        seq2.append(seq, std::max(len2, 0));
     }
 
-    // Copy elements to seq2
-
-    for (int c = 0; c < count; c++)
-    {
-        int copied_count = 0;
-        while (copied_count < len1 && it != seq.empty())
-        {
-            seq1.push_back(it.key(), it.info());
-            it++;
-            copied_count++;
-        }
-        copied_count = 0;
-        while (copied_count < len2 && it != seq.empty())
-        {
-            seq2.push_back(it.key(), it.info());
-            it++;
-            copied_count++;
-        }
-    }
+    // Put the remaining elements behind the prefix and the whole back to seq
+    prefix.append(seq);
+    seq.append(prefix);
+}
 
-    while (it != seq.empty())
-    {
-        new_sequence.push_back(it.key(), it.info());
-        ++it;
-    }
+template <typename Key, typename Info, bool KeyIndexed, typename NodeAllocation, bool PositionIndexed>
+void split_pos(/*const*/ Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq, int start_pos, int len1, int len2, int count, Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq1, Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq2)
+{
+    // The last element is never left in front, even if start_pos is past the end
+    int prefix_length = std::min(start_pos, seq.getLength() - 1);
 
-    seq = new_sequence;
+    split_runs(seq, prefix_length, len1, len2, count, seq1, seq2);
 }
 
-template <typename Key, typename Info>
-void split_key(/*const*/ Sequence<Key, Info> &seq, const Key &start_key, int start_occ, int len1, int len2, int count, Sequence<Key, Info> &seq1, Sequence<Key, Info> &seq2)
+template <typename Key, typename Info, bool KeyIndexed, typename NodeAllocation, bool PositionIndexed>
+void split_key(/*const*/ Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq, const Key &start_key, int start_occ, int len1, int len2, int count, Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq1, Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq2)
 {
-    typename Sequence<Key, Info>::Iterator target = seq.begin();
+    typename Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed>::Iterator target = seq.begin();
 
     if (!seq.find(target, start_key, start_occ))
     {
         throw std::runtime_error("Target not found");
     }
 
-    Sequence<Key, Info> new_sequence;
+    int prefix_length = 0;
     for (auto it = seq.begin(); it != target; it++)
     {
-        new_sequence.push_back(it.key(), it.info());
+        prefix_length++;
     }
-    auto it = target;
-    for (int c = 0; c < count; c++)
-    {
-
-        int copied_count = 0;
-        while (copied_count < len1 && it != seq.empty())
-        {
-            seq1.push_back(it.key(), it.info());
-            it++;
-            copied_count++;
-        }
 
-        copied_count = 0;
-        while (copied_count < len2 && it != seq.empty())
-        {
-            seq2.push_back(it.key(), it.info());
-            it++;
-            copied_count++;
-        }
-    }
+    split_runs(seq, prefix_length, len1, len2, count, seq1, seq2);
+}
 
-    while (it != seq.empty())
-    {
-        new_sequence.push_back(it.key(), it.info());
-        ++it;
-    }
+/**
+ * @brief split_pos() into sequences shared copy-on-write, copies of seq1 and seq2 are O(1).
+ * seq1 and seq2 are cloned first if other copies share them
+ */
+template <typename Key, typename Info, bool KeyIndexed, typename NodeAllocation, bool PositionIndexed>
+void split_pos(Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq, int start_pos, int len1, int len2, int count, copy_on_write<Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed>> &seq1, copy_on_write<Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed>> &seq2)
+{
+    split_pos(seq, start_pos, len1, len2, count, seq1.write(), seq2.write());
+}
 
-    seq = new_sequence;
+/**
+ * @brief split_key() into sequences shared copy-on-write, copies of seq1 and seq2 are O(1).
+ * seq1 and seq2 are cloned first if other copies share them
+ */
+template <typename Key, typename Info, bool KeyIndexed, typename NodeAllocation, bool PositionIndexed>
+void split_key(Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed> &seq, const Key &start_key, int start_occ, int len1, int len2, int count, copy_on_write<Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed>> &seq1, copy_on_write<Sequence<Key, Info, KeyIndexed, NodeAllocation, PositionIndexed>> &seq2)
+{
+    split_key(seq, start_key, start_occ, len1, len2, count, seq1.write(), seq2.write());
 }
 
-#endif // SPLIT_HPP
\ No newline at end of file
+#endif // SPLIT_HPP